@@ -0,0 +1,392 @@
+#include "BitBoard.hpp"
+#include "BoardMesh.hpp"
+#include "Chunk.hpp"
+#include "DensityPyramid.hpp"
+#include "Direction.hpp"
+#include "kernel.hpp"
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <ratio>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <x86intrin.h>
+
+// Times the building blocks of a tick one at a time: Chunk operations, the batch
+// kernel on synthetic neighbourhoods, and the BitBoard lookups that gather them.
+// The mesh the window draws a board with is timed too, since it needs no window,
+// and so is the density pyramid it draws a board with from far away.
+// Every benchmark is run in rounds long enough to dwarf the clock overhead, and
+// the fastest round is reported, which is the one least disturbed by the system.
+//
+// Cycles are read from the time stamp counter, so they tick at the nominal clock
+// rate rather than the core clock when the CPU boosts or throttles.
+
+namespace
+{
+    constexpr std::chrono::milliseconds RoundTime(50);
+    constexpr int Rounds = 7;
+
+    // Keeps the compiler from dropping work whose result is never used.
+    template <typename T>
+    void keep(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Hides a value from the optimizer, so that it cannot be folded into the code.
+    template <typename T>
+    [[nodiscard]] T opaque(T value)
+    {
+        asm volatile("" : "+r"(value));
+        return value;
+    }
+
+    struct Measurement
+    {
+        double nanoseconds = std::numeric_limits<double>::max();
+        double cycles = std::numeric_limits<double>::max();
+    };
+
+    // Calls body(), which performs ops operations, often enough to fill each round.
+    Measurement measure(size_t ops, const std::function<void()> &body)
+    {
+        size_t calls = 1;
+
+        // Grow the round until it takes long enough to time.
+        for (;;)
+        {
+            auto t1 = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < calls; i++)
+                body();
+            auto t2 = std::chrono::steady_clock::now();
+
+            if (t2 - t1 >= RoundTime / 4 || calls >= (size_t{1} << 40))
+                break;
+
+            calls *= 2;
+        }
+
+        Measurement best;
+
+        for (int round = 0; round < Rounds; round++)
+        {
+            auto t1 = std::chrono::steady_clock::now();
+            uint64_t c1 = __rdtsc();
+            for (size_t i = 0; i < calls; i++)
+                body();
+            uint64_t c2 = __rdtsc();
+            auto t2 = std::chrono::steady_clock::now();
+
+            auto total = static_cast<double>(calls * ops);
+            std::chrono::duration<double, std::nano> duration = t2 - t1;
+            best.nanoseconds = std::min(best.nanoseconds, duration.count() / total);
+            best.cycles = std::min(best.cycles, static_cast<double>(c2 - c1) / total);
+        }
+
+        return best;
+    }
+
+    class Suite
+    {
+    private:
+        std::string_view m_filter;
+
+    public:
+        explicit Suite(std::string_view filter) : m_filter(filter)
+        {
+            std::cout << std::left << std::setw(40) << "benchmark" << std::right << std::setw(12) << "ns/op" << std::setw(12) << "cycles/op" << '\n';
+        }
+
+        void run(std::string_view name, size_t ops, const std::function<void()> &body)
+        {
+            if (name.find(m_filter) == std::string_view::npos)
+                return;
+
+            Measurement result = measure(ops, body);
+            std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(3) << std::setw(12) << result.nanoseconds << std::setw(12) << result.cycles << '\n';
+        }
+    };
+
+    constexpr size_t Words = 1024;
+
+    [[nodiscard]] std::vector<Chunk> randomChunks(size_t count, std::mt19937_64 &random)
+    {
+        std::vector<Chunk> chunks;
+        chunks.reserve(count);
+
+        for (size_t i = 0; i < count; i++)
+            chunks.emplace_back(random());
+
+        return chunks;
+    }
+
+    void chunkBenchmarks(Suite &suite, std::mt19937_64 &random)
+    {
+        std::vector<Chunk> chunks = randomChunks(Words, random);
+        const unsigned int amount = opaque(7U); // a loop count, as in the tick
+
+        auto each = [&](std::string_view name, auto operation)
+        {
+            suite.run(name, Words, [&, operation]
+            {
+                for (const auto &chunk : chunks)
+                    keep(operation(chunk));
+            });
+        };
+
+        each("chunk/shiftLeft", [](Chunk chunk) { return chunk.shiftLeft(); });
+        each("chunk/shiftLeft(n)", [amount](Chunk chunk) { return chunk.shiftLeft(amount); });
+        each("chunk/shiftRight(n)", [amount](Chunk chunk) { return chunk.shiftRight(amount); });
+        each("chunk/shiftUp(n)", [amount](Chunk chunk) { return chunk.shiftUp(amount); });
+        each("chunk/shiftDown(n)", [amount](Chunk chunk) { return chunk.shiftDown(amount); });
+        each("chunk/get", [](Chunk chunk) { return chunk.get({3, 5}); });
+        each("chunk/set", [](Chunk chunk) { return chunk.set({3, 5}, true); });
+        each("chunk/edge", [](Chunk chunk) { return static_cast<bool>(chunk & Chunk::edge(Direction::SouthEast)); });
+        each("chunk/or-and-xor", [](Chunk chunk) { return (chunk | chunk.shiftUp()) ^ (chunk & chunk.shiftLeft()); });
+    }
+
+    void kernelBenchmarks(Suite &suite, std::mt19937_64 &random)
+    {
+        kernel::Batch batch;
+        batch.size = kernel::Batch::Capacity;
+
+        for (auto &words : batch.words)
+            for (auto &word : words)
+                word = random();
+
+        kernel::Results results{};
+        kernel::Variant selected = kernel::selected();
+
+        // Conway's rule and HighLife are compiled in; B35/S236 goes through the
+        // generic comparison.
+        const std::array<std::pair<std::string_view, kernel::Rule>, 3> rules = {{
+            {"", kernel::Conway},
+            {"/B36-S23", *kernel::parseRule("B36/S23")},
+            {"/B35-S236", *kernel::parseRule("B35/S236")},
+        }};
+
+        for (auto variant : {kernel::Variant::Scalar, kernel::Variant::Avx2, kernel::Variant::Avx512})
+        {
+            if (!kernel::supported(variant))
+                continue;
+
+            kernel::select(variant);
+
+            for (const auto &[suffix, rule] : rules)
+            {
+                suite.run("kernel/evolve/" + std::string(kernel::name(variant)) + std::string(suffix), batch.size, [&]
+                {
+                    kernel::evolve(batch, results, rule);
+                    keep(results);
+                });
+            }
+        }
+
+        kernel::select(selected);
+    }
+
+    void boardBenchmarks(Suite &suite, std::mt19937_64 &random)
+    {
+        constexpr int Extent = 256; // chunks on each side of the board
+        constexpr size_t Lookups = 4096;
+
+        BitBoard board;
+
+        for (int y = 0; y < Extent; y++)
+            for (int x = 0; x < Extent; x++)
+                board.store({x, y}, Chunk(random() | 1));
+
+        std::uniform_int_distribution<int> coordinate(1, Extent - 2);
+        std::vector<BitBoard::ChunkPos> positions;
+        std::vector<BitBoard::BitPos> cells;
+
+        for (size_t i = 0; i < Lookups; i++)
+        {
+            positions.emplace_back(coordinate(random), coordinate(random));
+            cells.emplace_back(coordinate(random) * 8, coordinate(random) * 8);
+        }
+
+        suite.run("board/locate", Lookups, [&]
+        {
+            for (auto pos : positions)
+                keep(board.locate(pos));
+        });
+
+        suite.run("board/find", Lookups, [&]
+        {
+            for (auto pos : positions)
+                keep(board.find(pos)->chunk);
+        });
+
+        suite.run("board/get", Lookups, [&]
+        {
+            for (auto cell : cells)
+                keep(board.get(cell));
+        });
+
+        suite.run("board/set", Lookups, [&]
+        {
+            for (auto cell : cells)
+                board.set(cell, true);
+        });
+
+        suite.run("board/store", Lookups, [&]
+        {
+            for (auto pos : positions)
+                board.store(pos, Chunk(~uint64_t{0}));
+        });
+
+        // The two ways of gathering a neighbourhood: eight map lookups, or the
+        // slot's neighbor links.
+        suite.run("board/neighbourhood/find", Lookups, [&]
+        {
+            for (auto pos : positions)
+                for (auto direction : Direction::All)
+                    keep(board.find(direction.offset(pos))->chunk);
+        });
+
+        std::vector<BitBoard::Index> slots;
+
+        for (auto pos : positions)
+            slots.push_back(board.locate(pos));
+
+        suite.run("board/neighbourhood/links", Lookups, [&]
+        {
+            for (auto slot : slots)
+                for (auto neighbor : board.neighbors(slot))
+                    keep(board.chunk(neighbor));
+        });
+
+        // Per chunk found in a 50x50 range.
+        suite.run("board/query", 50 * 50, [&]
+        {
+            board.query({100, 100}, {149, 149}, [](const Chunk &chunk, BitBoard::ChunkPos) { keep(chunk); });
+        });
+    }
+
+    // Building the triangles the window draws a board with, per live chunk.
+    void renderBenchmarks(Suite &suite, std::mt19937_64 &random)
+    {
+        constexpr int Extent = 256;
+
+        BitBoard board;
+
+        for (int y = 0; y < Extent; y++)
+            for (int x = 0; x < Extent; x++)
+                board.store({x, y}, Chunk(random() & random()));
+
+        BoardMesh mesh;
+
+        suite.run("render/mesh", board.size(), [&]
+        {
+            mesh.build(board, sf::Color::White);
+            keep(mesh.size());
+        });
+
+        // A 50x50 chunk window into the same board, reported per chunk in view.
+        constexpr int Window = 50;
+        const BitBoard::ChunkPos min = {Extent / 2, Extent / 2};
+        const BitBoard::ChunkPos max = min + BitBoard::ChunkPos(Window - 1, Window - 1);
+
+        suite.run("render/mesh/visible", Window * Window, [&]
+        {
+            mesh.build(board, sf::Color::White, min, max);
+            keep(mesh.size());
+        });
+
+        // The same window kept up to date, going back and forth between two boards
+        // that differ in one chunk out of sixteen.
+        BitBoard changed = board;
+
+        for (int y = 0; y < Extent; y += 4)
+            for (int x = 0; x < Extent; x += 4)
+                changed.store({x, y}, Chunk(random() & random()));
+
+        BoardMesh slotted;
+        bool flip = false;
+
+        suite.run("render/mesh/update", Window * Window, [&]
+        {
+            flip = !flip;
+            slotted.update(flip ? changed : board, sf::Color::White, min, max);
+            slotted.clean();
+            keep(slotted.size());
+        });
+
+        DensityPyramid density;
+
+        suite.run("render/density/rebuild", board.size(), [&]
+        {
+            density.rebuild(board);
+            keep(density.getGeneration());
+        });
+
+        // Going back and forth between the boards of render/mesh/update again, each
+        // listing the chunks that differ from the other, reported per chunk listed.
+        BitBoard forth = board;
+        BitBoard back = changed;
+        forth.beginChanges(board.getGeneration());
+        back.beginChanges(board.getGeneration());
+
+        for (int y = 0; y < Extent; y += 4)
+        {
+            for (int x = 0; x < Extent; x += 4)
+            {
+                auto before = board.find({x, y});
+                auto after = changed.find({x, y});
+                back.store({x, y}, before != board.end() ? before->chunk : Chunk());
+                forth.store({x, y}, after != changed.end() ? after->chunk : Chunk());
+            }
+        }
+
+        flip = false;
+
+        suite.run("render/density/update", forth.changes().size(), [&]
+        {
+            flip = !flip;
+            density.update(flip ? forth : back);
+            keep(density.getGeneration());
+        });
+
+        density.rebuild(board);
+
+        // The whole board at level 4, reported per tile drawn.
+        constexpr unsigned int Level = 4;
+        constexpr int Tiles = Extent >> Level;
+
+        suite.run("render/density/mesh", Tiles * Tiles, [&]
+        {
+            mesh.build(density, Level, sf::Color::White, {0, 0}, {Extent - 1, Extent - 1});
+            keep(mesh.size());
+        });
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    std::string_view filter = argc > 1 ? argv[1] : "";
+
+    std::mt19937_64 random(1);
+    Suite suite(filter);
+
+    chunkBenchmarks(suite, random);
+    kernelBenchmarks(suite, random);
+    boardBenchmarks(suite, random);
+    renderBenchmarks(suite, random);
+
+    return 0;
+}
@@ -5,16 +5,18 @@
 #include "utility.hpp"
 
 #include <SFML/System/Vector2.hpp>
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <bitset>
 #include <boost/container_hash/hash.hpp>
 #include <boost/core/bit.hpp>
 #include <boost/unordered/unordered_flat_map.hpp>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <limits>
-#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -32,70 +34,195 @@ namespace boost
     };
 }
 
-class BitBoard
+// Sparse board of ChunkT tiles, stored as one array per field of a slot so the
+// tick streams through the chunk words without dragging positions and neighbor
+// links through the cache. Iterating yields {chunk, pos} pairs for the live
+// chunks of the current generation, which structured bindings unpack directly.
+template <typename ChunkT>
+class BasicBitBoard
 {
 public:
+    using Chunk = ChunkT;
     using BitPos = sf::Vector2i;
     using ChunkPos = sf::Vector2i;
-    using Index = std::size_t;
-    using Generation = unsigned int;
+    using Index = uint32_t;
+    using Generation = uint64_t;
+    using Neighbors = std::array<Index, 8>;
 
     static constexpr Index Invalid = std::numeric_limits<Index>::max();
+    static constexpr size_t ScatterThreshold = 1 << 14;
 
-    struct Node
+    // Bits of activity().
+    static constexpr uint8_t ChangedOne = 1; // differs from the chunk one generation earlier
+    static constexpr uint8_t ChangedTwo = 2; // differs from the chunk two generations earlier
+    static constexpr uint8_t Active = ChangedOne | ChangedTwo;
+
+private:
+    std::vector<Chunk> m_chunks;
+    std::vector<Chunk> m_previous;         // the chunk one generation earlier
+    std::vector<Generation> m_generations; // generation in which the slot was last live
+    std::vector<uint8_t> m_activities;
+    std::vector<ChunkPos> m_positions;
+    std::vector<Neighbors> m_neighbors;
+    boost::unordered::unordered_flat_map<ChunkPos, Index> m_map;
+    boost::unordered::unordered_flat_map<ChunkPos, uint64_t> m_blocks; // positions in m_map, one bit each, by block of 8x8
+    Generation m_generation;
+    std::vector<uint64_t> m_taken;      // one bit per slot that is live or on the frontier
+    std::vector<uint64_t> m_onFrontier; // one bit per slot on the frontier
+    size_t m_firstFree;                 // word of m_taken before which every slot is taken
+    size_t m_size;
+    std::vector<Index> m_frontier;
+    unsigned int m_history = 0;
+    std::vector<ChunkPos> m_changes; // see changes()
+    Generation m_changesSince = 0;   // 0 while changes() is not known
+    size_t m_allocations = 0;
+    size_t m_probes = 0;
+    size_t m_laidOut = 0; // m_allocations at the last relayout()
+
+    // Safe against concurrent mark().
+    [[nodiscard]] static bool test(std::vector<uint64_t> &bits, Index index)
     {
-        Chunk chunk;
-        Generation generation = 0;
+        std::atomic_ref<uint64_t> word(bits[index / 64]);
+        return word.load(std::memory_order_relaxed) & (uint64_t{1} << (index % 64));
+    }
 
-        constexpr Node(Chunk chunk, Generation generation) : chunk(chunk), generation(generation) {}
-    };
+    // Sets the bit and returns whether it was set before. Safe to call from several
+    // threads at once.
+    static bool mark(std::vector<uint64_t> &bits, Index index)
+    {
+        std::atomic_ref<uint64_t> word(bits[index / 64]);
+        uint64_t bit = uint64_t{1} << (index % 64);
+        return word.fetch_or(bit, std::memory_order_relaxed) & bit;
+    }
 
-    struct Meta
+    void take(Index index)
     {
-        Index index;
-        ChunkPos pos;
-        std::array<Index, 8> neighbors = {Invalid, Invalid, Invalid, Invalid, Invalid, Invalid, Invalid, Invalid};
+        mark(m_taken, index);
+    }
 
-        constexpr Meta(Index index, ChunkPos pos) : index(index), pos(pos) {}
-    };
+    [[nodiscard]] static constexpr ChunkPos block(ChunkPos pos)
+    {
+        return {pos.x >> 3, pos.y >> 3};
+    }
 
-private:
-    std::vector<Node> m_nodes;
-    std::vector<Meta> m_metas;
-    boost::unordered::unordered_flat_map<ChunkPos, Index> m_map;
-    Generation m_generation;
-    Index m_firstReusable;
-    size_t m_size;
+    [[nodiscard]] static constexpr uint64_t blockBit(ChunkPos pos)
+    {
+        return uint64_t{1} << (((pos.y & 7) * 8) + (pos.x & 7));
+    }
 
-    Index allocate(Chunk chunk, ChunkPos pos)
+    void unmap(ChunkPos pos)
     {
-        Index index; // NOLINT(cppcoreguidelines-init-variables)
+        auto entry = m_blocks.find(block(pos));
+        assert(entry != m_blocks.end());
+
+        if (!(entry->second &= ~blockBit(pos)))
+            m_blocks.erase(entry);
+    }
+
+    // Marks every slot as taken and none as on the frontier.
+    void takeAll()
+    {
+        m_taken.assign(capacity() / 64, ~uint64_t{0});
+        m_firstFree = m_taken.size();
+
+        if (capacity() % 64)
+            m_taken.push_back((uint64_t{1} << (capacity() % 64)) - 1);
+
+        m_onFrontier.assign(m_taken.size(), 0);
+    }
 
-        for (index = m_firstReusable; index < m_nodes.size(); index++)
-            if (m_nodes[index].generation != m_generation)
+    // Hands out the first slot that is neither live nor on the frontier. Slots only
+    // become free when the generation changes, so the cursor never has to move back
+    // and each word of the bitmap is probed about once per generation.
+    Index allocate(const Chunk &chunk, ChunkPos pos, Generation generation)
+    {
+        Index index = capacity();
+
+        for (; m_firstFree < m_taken.size(); m_firstFree++)
+        {
+            m_probes++;
+
+            // Bits past the last slot are never set, so a word with room in it
+            // yields either a stale slot or the next one to append.
+            if (uint64_t free = ~m_taken[m_firstFree]; free)
+            {
+                index = static_cast<Index>((m_firstFree * 64) + static_cast<size_t>(boost::core::countr_zero(free)));
                 break;
+            }
+        }
 
-        m_firstReusable = index + 1;
+        m_allocations++;
 
-        if (index < m_nodes.size())
+        if (index < capacity())
         {
-            m_nodes[index].chunk = chunk;
-            m_nodes[index].generation = m_generation;
+            m_chunks[index] = chunk;
+            m_previous[index] = Chunk();
+            m_generations[index] = generation;
+            m_activities[index] = Active;
             disconnect(index);
             connect(index, pos);
         }
         else
         {
-            index = m_nodes.size();
-            m_nodes.emplace_back(chunk, m_generation);
-            m_metas.emplace_back(index, pos);
+            index = capacity();
+            assert(index != Invalid);
+            m_chunks.push_back(chunk);
+            m_previous.emplace_back();
+            m_generations.push_back(generation);
+            m_activities.push_back(Active);
+            m_positions.push_back(pos);
+            m_neighbors.emplace_back();
             connect(index, pos);
+
+            if (index / 64 == m_taken.size())
+            {
+                m_taken.push_back(0);
+                m_onFrontier.push_back(0);
+            }
         }
 
-        m_size++;
+        take(index);
         return index;
     }
 
+    Index allocate(const Chunk &chunk, ChunkPos pos)
+    {
+        m_size++;
+        return allocate(chunk, pos, m_generation);
+    }
+
+    // Makes a slot stale. Its neighbors may still have live edge cells next to it, so
+    // it stays on the frontier; that also keeps it from being handed out again.
+    void release(Index index)
+    {
+        m_generations[index] = 0;
+
+        if (claimFrontier(index))
+            addFrontier(index);
+    }
+
+    // Adds the empty neighbors touched by the edge cells of the live chunk at index.
+    void extendFrontier(Index index)
+    {
+        std::bitset<8> touched;
+
+        for (auto direction : Direction::All)
+            touched[direction] = static_cast<bool>(m_chunks[index] & Chunk::edge(direction));
+
+        for (auto direction : Direction::All)
+        {
+            if (!touched[direction])
+                continue;
+
+            Index other = m_neighbors[index][direction]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+
+            if (other == Invalid)
+                addFrontier(direction.offset(m_positions[index]));
+            else if (claimFrontier(other))
+                addFrontier(other);
+        }
+    }
+
     // NOLINTNEXTLINE(misc-no-recursion)
     void connect(Index index, Direction direction, Index other, std::bitset<8> &assigned)
     {
@@ -103,22 +230,22 @@ private:
             return;
 
         assigned[direction] = true;
-        m_metas[index].neighbors[direction] = other; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        m_neighbors[index][direction] = other; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
 
         if (other == Invalid)
             return;
 
-        Meta &otherMeta = m_metas[other];
-        otherMeta.neighbors[direction.opposite()] = index; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        Neighbors &otherNeighbors = m_neighbors[other];
+        otherNeighbors[direction.opposite()] = index; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
 
         for (auto [otherDirection, neighborDirection] : direction.indirects())
-            connect(index, neighborDirection, otherMeta.neighbors[otherDirection], assigned); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            connect(index, neighborDirection, otherNeighbors[otherDirection], assigned); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
     }
 
     void connect(Index index, ChunkPos pos)
     {
-        Meta &meta = m_metas[index];
-        meta = Meta(index, pos);
+        m_positions[index] = pos;
+        m_neighbors[index].fill(Invalid);
 
         std::bitset<8> assigned;
 
@@ -132,42 +259,42 @@ private:
         }
 
         m_map[pos] = index;
+        m_blocks[block(pos)] |= blockBit(pos);
     }
 
     void disconnect(Index index)
     {
-        Meta &meta = m_metas[index];
+        const Neighbors &neighbors = m_neighbors[index];
 
         for (auto direction : Direction::All)
-            if (meta.neighbors[direction] != Invalid)                                         // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
-                m_metas[meta.neighbors[direction]].neighbors[direction.opposite()] = Invalid; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            if (neighbors[direction] != Invalid)                                        // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+                m_neighbors[neighbors[direction]][direction.opposite()] = Invalid; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
 
-        m_map.erase(meta.pos);
+        m_map.erase(m_positions[index]);
+        unmap(m_positions[index]);
     }
 
 public:
     class const_iterator
     {
     private:
-        const std::vector<Node> *m_nodes;
-        const std::vector<Meta> *m_metas;
-        Generation m_generation;
+        const BasicBitBoard *m_board;
         Index m_index;
 
         constexpr void skipStale()
         {
-            assert(m_nodes && m_metas);
-            while (m_index < m_nodes->size() && (*m_nodes)[m_index].generation != m_generation)
+            assert(m_board);
+            while (m_index < m_board->capacity() && !m_board->live(m_index))
                 m_index++;
         }
 
     public:
         struct reference
         {
-            const Node &node; // NOLINT(cppcoreguidelines-avoid-const-or-ref-data-members)
-            const Meta &meta; // NOLINT(cppcoreguidelines-avoid-const-or-ref-data-members)
+            const Chunk &chunk; // NOLINT(cppcoreguidelines-avoid-const-or-ref-data-members)
+            ChunkPos pos;
 
-            constexpr reference(const Node &node, const Meta &meta) : node(node), meta(meta) {}
+            constexpr reference(const Chunk &chunk, ChunkPos pos) : chunk(chunk), pos(pos) {}
 
             constexpr reference *operator->() noexcept
             {
@@ -180,22 +307,20 @@ public:
         using value_type = reference;
         using pointer = reference *;
 
-        constexpr const_iterator(const std::vector<Node> *nodes, const std::vector<Meta> *metas, Generation generation, Index index) : m_nodes(nodes), m_metas(metas), m_generation(generation), m_index(index)
+        constexpr const_iterator(const BasicBitBoard *board, Index index) : m_board(board), m_index(index)
         {
-            assert(nodes->size() == metas->size());
             skipStale();
         }
 
         constexpr reference operator*() const
         {
-            assert(m_nodes && m_metas && m_index < m_nodes->size() && m_index < m_metas->size());
-            return {(*m_nodes)[m_index], (*m_metas)[m_index]};
+            assert(m_board && m_index < m_board->capacity());
+            return {m_board->m_chunks[m_index], m_board->m_positions[m_index]};
         }
 
         constexpr reference operator->() const
         {
-            assert(m_nodes && m_metas && m_index < m_nodes->size() && m_index < m_metas->size());
-            return {(*m_nodes)[m_index], (*m_metas)[m_index]};
+            return **this;
         }
 
         constexpr const_iterator &operator++()
@@ -215,7 +340,7 @@ public:
 
         constexpr bool operator==(const const_iterator &other) const
         {
-            return m_nodes == other.m_nodes && m_metas == other.m_metas && m_generation == other.m_generation && m_index == other.m_index;
+            return m_board == other.m_board && m_index == other.m_index;
         }
 
         constexpr bool operator!=(const const_iterator &other) const
@@ -224,105 +349,553 @@ public:
         }
     };
 
-    BitBoard() : m_generation(1), m_firstReusable(0), m_size(0) {}
-    BitBoard(Generation generation) : m_generation(generation), m_firstReusable(0), m_size(0) {}
+    BasicBitBoard() : m_generation(1), m_firstFree(0), m_size(0) {}
+    BasicBitBoard(Generation generation) : m_generation(generation), m_firstFree(0), m_size(0) {}
 
-    BitBoard &set(BitPos pos, bool state)
+    BasicBitBoard &set(BitPos pos, bool state)
     {
-        ChunkPos chunkPos = utility::floorDiv(pos, {8, 8});
-        BitPos localPos = pos - (chunkPos * 8);
+        m_history = 0;
+
+        ChunkPos chunkPos = utility::floorDiv(pos, {static_cast<int>(Chunk::Size), static_cast<int>(Chunk::Size)});
+        BitPos localPos = pos - (chunkPos * static_cast<int>(Chunk::Size));
 
         if (auto entry = m_map.find(chunkPos); entry != m_map.end())
         {
-            Node &node = m_nodes[entry->second];
+            Index index = entry->second;
 
-            if (node.generation == m_generation)
+            if (live(index))
             {
-                if (!node.chunk.set(localPos, state))
+                if (!m_chunks[index].set(localPos, state))
                 {
                     m_size--;
-                    node.generation = 0;
+                    release(index);
                 }
             }
             else if (state)
             {
                 m_size++;
-                node.chunk = Chunk().set(localPos, state);
-                node.generation = m_generation;
+                m_chunks[index] = Chunk().set(localPos, state);
+                m_generations[index] = m_generation;
+                take(index);
             }
+
+            m_activities[index] = Active;
+
+            if (state)
+                extendFrontier(index);
         }
         else if (state)
         {
-            allocate(Chunk().set(localPos, state), chunkPos);
+            extendFrontier(allocate(Chunk().set(localPos, state), chunkPos));
         }
 
+        noteChange(chunkPos);
         return *this;
     }
 
     [[nodiscard]] bool get(BitPos pos) const
     {
-        ChunkPos chunkPos = utility::floorDiv(pos, {8, 8});
-        BitPos localPos = pos - (chunkPos * 8);
+        ChunkPos chunkPos = utility::floorDiv(pos, {static_cast<int>(Chunk::Size), static_cast<int>(Chunk::Size)});
+        BitPos localPos = pos - (chunkPos * static_cast<int>(Chunk::Size));
 
         if (auto entry = m_map.find(chunkPos); entry != m_map.end())
-            return m_nodes[entry->second].chunk.get(localPos);
+            return m_chunks[entry->second].get(localPos);
 
         return false;
     }
 
     [[nodiscard]] constexpr const_iterator begin() const
     {
-        return {&m_nodes, &m_metas, m_generation, 0};
+        return {this, 0};
     }
 
     [[nodiscard]] constexpr const_iterator end() const
     {
-        return {&m_nodes, &m_metas, m_generation, m_nodes.size()};
+        return {this, capacity()};
     }
 
     [[nodiscard]] const_iterator find(ChunkPos pos) const
     {
         if (auto entry = m_map.find(pos); entry != m_map.end())
+            return at(entry->second);
+
+        return end();
+    }
+
+    // Calls visit(chunk, pos) for every live chunk with min <= pos <= max. Goes
+    // through the blocks of 8x8 positions that overlap the range, or through every
+    // block the board has when those are fewer, so the cost follows the size of the
+    // range or of the board, whichever is smaller, plus the chunks in the range.
+    template <typename Visit>
+    void query(ChunkPos min, ChunkPos max, Visit &&visit) const
+    {
+        if (min.x > max.x || min.y > max.y)
+            return;
+
+        const ChunkPos first = block(min);
+        const ChunkPos last = block(max);
+
+        auto visitBlock = [&](ChunkPos blockPos, uint64_t bits)
         {
-            if (m_nodes[entry->second].generation != m_generation)
-                return end();
+            for (; bits; bits &= bits - 1)
+            {
+                auto bit = static_cast<int>(boost::core::countr_zero(bits));
+                ChunkPos pos = {(blockPos.x * 8) + (bit % 8), (blockPos.y * 8) + (bit / 8)};
 
-            return {&m_nodes, &m_metas, m_generation, entry->second};
-        }
+                if (pos.x < min.x || pos.x > max.x || pos.y < min.y || pos.y > max.y)
+                    continue;
 
-        return end();
+                Index index = m_map.find(pos)->second;
+
+                if (live(index))
+                    visit(m_chunks[index], pos);
+            }
+        };
+
+        const auto blocksInRange = static_cast<uint64_t>((int64_t{last.x} - first.x + 1) * (int64_t{last.y} - first.y + 1));
+
+        if (blocksInRange <= m_blocks.size())
+        {
+            for (int y = first.y; y <= last.y; y++)
+                for (int x = first.x; x <= last.x; x++)
+                    if (auto entry = m_blocks.find({x, y}); entry != m_blocks.end())
+                        visitBlock(entry->first, entry->second);
+        }
+        else
+        {
+            for (const auto &[blockPos, bits] : m_blocks)
+                if (blockPos.x >= first.x && blockPos.x <= last.x && blockPos.y >= first.y && blockPos.y <= last.y)
+                    visitBlock(blockPos, bits);
+        }
     }
 
-    BitBoard &store(ChunkPos pos, Chunk chunk)
+    BasicBitBoard &store(ChunkPos pos, const Chunk &chunk)
     {
+        m_history = 0;
+
         if (auto entry = m_map.find(pos); entry != m_map.end())
         {
-            Node &node = m_nodes[entry->second];
+            Index index = entry->second;
 
             if (chunk)
             {
-                if (node.generation != m_generation)
+                if (!live(index))
                     m_size++;
 
-                node.chunk = chunk;
-                node.generation = m_generation;
+                m_chunks[index] = chunk;
+                m_generations[index] = m_generation;
+                m_activities[index] = Active;
+                take(index);
+                extendFrontier(index);
             }
             else
             {
-                if (node.generation == m_generation)
+                if (live(index))
                     m_size--;
 
-                node.generation = 0;
+                release(index);
             }
         }
         else if (chunk)
         {
-            allocate(chunk, pos);
+            extendFrontier(allocate(chunk, pos));
         }
 
+        noteChange(pos);
         return *this;
     }
 
+    // Slot currently mapped to pos, live or stale, or Invalid if there is none.
+    [[nodiscard]] Index locate(ChunkPos pos) const
+    {
+        if (auto entry = m_map.find(pos); entry != m_map.end())
+            return entry->second;
+
+        return Invalid;
+    }
+
+    // Makes a stale slot returned by locate() live with new contents. Does not touch
+    // size() or the frontier, so disjoint slots may be revived from several threads
+    // at once; report the total through addRevived() and the empty neighbors through
+    // claimFrontier() and addFrontier() afterwards.
+    void revive(Index index, const Chunk &chunk, const Chunk &previous, uint8_t activity)
+    {
+        assert(index < capacity() && !live(index));
+        m_chunks[index] = chunk;
+        m_previous[index] = previous;
+        m_generations[index] = m_generation;
+        m_activities[index] = activity;
+        take(index);
+    }
+
+    // Like store(), but for chunks produced by a tick: an empty chunk whose activity
+    // is not zero yet is kept, so its neighbors still see that it changed.
+    void insert(ChunkPos pos, const Chunk &chunk, const Chunk &previous, uint8_t activity)
+    {
+        Index index = locate(pos);
+
+        if (index == Invalid)
+        {
+            index = allocate(chunk, pos);
+        }
+        else
+        {
+            revive(index, chunk, previous, activity);
+            m_size++;
+        }
+
+        m_previous[index] = previous;
+        m_activities[index] = activity;
+        extendFrontier(index);
+    }
+
+    // Generations of history behind the activity of the slots: 0 after the board was
+    // edited, up to 2 for a board that was ticked twice in a row since.
+    [[nodiscard]] constexpr unsigned int history() const
+    {
+        return m_history;
+    }
+
+    constexpr void setHistory(unsigned int history)
+    {
+        m_history = history;
+    }
+
+    // Positions of the chunks that may differ from the board of generation
+    // changesSince() this one was ticked from, with repeats: the ones the ticks in
+    // between changed and the ones edited since. Only meaningful while changesSince()
+    // is not 0; the list is dropped once it grows past capacity(), as counting the
+    // whole board is no slower by then.
+    [[nodiscard]] constexpr const std::vector<ChunkPos> &changes() const
+    {
+        return m_changes;
+    }
+
+    [[nodiscard]] constexpr Generation changesSince() const
+    {
+        return m_changesSince;
+    }
+
+    // Starts an empty list of changes from the board of the given generation.
+    void beginChanges(Generation since)
+    {
+        assert(since > 0);
+        m_changes.clear();
+        m_changesSince = since;
+    }
+
+    void forgetChanges()
+    {
+        m_changes.clear();
+        m_changesSince = 0;
+    }
+
+    void noteChange(ChunkPos pos)
+    {
+        if (m_changesSince == 0)
+            return;
+
+        if (m_changes.size() >= capacity())
+            return forgetChanges();
+
+        m_changes.push_back(pos);
+    }
+
+    // Takes on the changes of earlier, which this board was ticked from, so that the
+    // list reaches back as far as the one of earlier does.
+    void addChanges(const BasicBitBoard &earlier)
+    {
+        if (m_changesSince == 0)
+            return;
+
+        if (earlier.m_changesSince == 0 || m_changes.size() + earlier.m_changes.size() > capacity())
+            return forgetChanges();
+
+        m_changes.insert(m_changes.end(), earlier.m_changes.begin(), earlier.m_changes.end());
+        m_changesSince = earlier.m_changesSince;
+    }
+
+    constexpr void addRevived(size_t count)
+    {
+        m_size += count;
+    }
+
+    // Stale slots next to live edge cells of the current generation: the only places
+    // where a chunk can be born in the next one. Every such position is listed once,
+    // but slots that have been written to since they were added may be listed too.
+    [[nodiscard]] constexpr const std::vector<Index> &frontier() const
+    {
+        return m_frontier;
+    }
+
+    // Whether the slot holds a chunk of the current generation. Invalid is never live.
+    [[nodiscard]] constexpr bool live(Index index) const
+    {
+        return index != Invalid && m_generations[index] == m_generation;
+    }
+
+    [[nodiscard]] constexpr const Chunk &chunk(Index index) const
+    {
+        assert(index < capacity());
+        return m_chunks[index];
+    }
+
+    [[nodiscard]] constexpr const Chunk &previous(Index index) const
+    {
+        assert(index < capacity());
+        return m_previous[index];
+    }
+
+    [[nodiscard]] constexpr uint8_t activity(Index index) const
+    {
+        assert(index < capacity());
+        return m_activities[index];
+    }
+
+    [[nodiscard]] constexpr ChunkPos position(Index index) const
+    {
+        assert(index < capacity());
+        return m_positions[index];
+    }
+
+    [[nodiscard]] constexpr const Neighbors &neighbors(Index index) const
+    {
+        assert(index < capacity());
+        return m_neighbors[index];
+    }
+
+    // Marks a slot as part of the frontier. Returns false if the slot is live or was
+    // already marked; otherwise the caller has to pass it on to addFrontier(). Any
+    // number of threads may claim slots at once.
+    bool claimFrontier(Index index)
+    {
+        assert(index < capacity());
+
+        if (live(index))
+            return false;
+
+        // Most slots are seen from several sides; only the first one pays for the atomic.
+        if (test(m_onFrontier, index) || mark(m_onFrontier, index))
+            return false;
+
+        take(index);
+        return true;
+    }
+
+    void addFrontier(Index index)
+    {
+        assert(test(m_onFrontier, index));
+        m_frontier.push_back(index);
+    }
+
+    // Adds the position to the frontier, giving it an empty slot first if it has none.
+    void addFrontier(ChunkPos pos)
+    {
+        Index index = locate(pos);
+
+        if (index == Invalid)
+        {
+            index = allocate(Chunk(), pos, 0);
+            mark(m_onFrontier, index);
+            m_frontier.push_back(index);
+        }
+        else if (claimFrontier(index))
+        {
+            m_frontier.push_back(index);
+        }
+    }
+
+    // Slots handed out and bitmap words probed to find them, over the life of the board.
+    [[nodiscard]] constexpr size_t allocations() const
+    {
+        return m_allocations;
+    }
+
+    [[nodiscard]] constexpr size_t probes() const
+    {
+        return m_probes;
+    }
+
+    // Memory held by the slots, their bitmaps and the position map.
+    [[nodiscard]] size_t bytes() const
+    {
+        auto held = []<typename T>(const std::vector<T> &vector)
+        {
+            return vector.capacity() * sizeof(T);
+        };
+
+        // An open addressing map spends about a byte of metadata per bucket.
+        size_t map = m_map.bucket_count() * (sizeof(typename decltype(m_map)::value_type) + 1);
+        size_t blocks = m_blocks.bucket_count() * (sizeof(typename decltype(m_blocks)::value_type) + 1);
+
+        return held(m_chunks) + held(m_previous) + held(m_generations) + held(m_activities) + held(m_positions) + held(m_neighbors) +
+               held(m_taken) + held(m_onFrontier) + held(m_frontier) + held(m_changes) + map + blocks;
+    }
+
+    // True once half as many slots were handed out since the last relayout() as the
+    // board has: by then the order of the slots says little about their positions.
+    // Boards below ScatterThreshold slots fit in cache in any order.
+    [[nodiscard]] constexpr bool scattered() const
+    {
+        return capacity() >= ScatterThreshold && m_allocations - m_laidOut > capacity() / 2;
+    }
+
+    // Sorts the slots in Z-order of their positions and drops the ones that are
+    // neither live nor on the frontier, so that chunks which are neighbors on the
+    // board mostly are neighbors in memory too. Every Index handed out before,
+    // including the ones in neighbors and frontier(), is renumbered.
+    void relayout()
+    {
+        std::vector<std::pair<uint64_t, Index>> order;
+        order.reserve(capacity());
+
+        for (Index index = 0; index < capacity(); index++)
+            if (test(m_taken, index))
+                order.emplace_back(utility::morton(m_positions[index]), index);
+
+        std::sort(order.begin(), order.end());
+
+        std::vector<Index> renumbered(capacity(), Invalid);
+
+        for (size_t index = 0; index < order.size(); index++)
+            renumbered[order[index].second] = static_cast<Index>(index);
+
+        auto permute = [&]<typename T>(std::vector<T> &vector)
+        {
+            std::vector<T> permuted;
+            permuted.reserve(order.size());
+
+            for (auto [code, index] : order)
+                permuted.push_back(vector[index]);
+
+            vector = std::move(permuted);
+        };
+
+        permute(m_chunks);
+        permute(m_previous);
+        permute(m_generations);
+        permute(m_activities);
+        permute(m_positions);
+        permute(m_neighbors);
+
+        for (auto &neighbors : m_neighbors)
+            for (auto &neighbor : neighbors)
+                if (neighbor != Invalid)
+                    neighbor = renumbered[neighbor];
+
+        for (auto entry = m_map.begin(); entry != m_map.end();)
+        {
+            if (Index index = renumbered[entry->second]; index != Invalid)
+            {
+                entry->second = index;
+                ++entry;
+            }
+            else
+            {
+                unmap(entry->first);
+                entry = m_map.erase(entry);
+            }
+        }
+
+        // Every slot left is taken, and the frontier keeps its own list.
+        takeAll();
+
+        for (auto &index : m_frontier)
+        {
+            index = renumbered[index];
+            mark(m_onFrontier, index);
+        }
+
+        m_laidOut = m_allocations;
+    }
+
+    // Replaces the contents with count live chunks of the given generation, where
+    // source(i) returns the i-th as a {pos, chunk} pair. The chunks must not be empty
+    // and must come sorted by row and then by column, as a snapshot stores them:
+    // that lets neighbors be linked by walking two rows side by side, so nothing but
+    // the position map itself is hashed into.
+    template <typename Source>
+    void assign(Generation generation, Index count, Source source)
+    {
+        assert(generation > 0 && count != Invalid);
+        clear();
+        m_generation = generation;
+
+        m_chunks.reserve(count);
+        m_previous.assign(count, Chunk());
+        m_generations.assign(count, generation);
+        m_activities.assign(count, Active);
+        m_positions.reserve(count);
+        m_neighbors.reserve(count);
+        m_map.reserve(count);
+
+        for (Index index = 0; index < count; index++)
+        {
+            auto [pos, chunk] = source(index);
+            assert(chunk && (index == 0 || std::pair(m_positions.back().y, m_positions.back().x) < std::pair(pos.y, pos.x)));
+            m_chunks.push_back(chunk);
+            m_positions.push_back(pos);
+            m_neighbors.emplace_back().fill(Invalid);
+            m_map.emplace(pos, index);
+            m_blocks[block(pos)] |= blockBit(pos);
+        }
+
+        takeAll();
+        m_size = count;
+
+        auto link = [&](Index index, Direction direction, Index other)
+        {
+            m_neighbors[index][direction] = other;             // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            m_neighbors[other][direction.opposite()] = index; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        };
+
+        constexpr std::array<Direction, 3> Above = {Direction::NorthWest, Direction::North, Direction::NorthEast};
+
+        Index aboveBegin = 0;
+        Index aboveEnd = 0;
+
+        for (Index rowBegin = 0; rowBegin < count;)
+        {
+            const int y = m_positions[rowBegin].y;
+            Index rowEnd = rowBegin;
+
+            while (rowEnd < count && m_positions[rowEnd].y == y)
+                rowEnd++;
+
+            const bool adjacent = aboveEnd > aboveBegin && int64_t{m_positions[aboveBegin].y} + 1 == y;
+            Index above = aboveBegin;
+
+            for (Index index = rowBegin; index < rowEnd; index++)
+            {
+                const int64_t x = m_positions[index].x;
+
+                if (index > rowBegin && m_positions[index - 1].x + int64_t{1} == x)
+                    link(index, Direction::West, index - 1);
+
+                if (!adjacent)
+                    continue;
+
+                while (above < aboveEnd && m_positions[above].x < x - 1)
+                    above++;
+
+                for (Index other = above; other < aboveEnd && m_positions[other].x <= x + 1; other++)
+                    link(index, Above[static_cast<size_t>(m_positions[other].x - x + 1)], other);
+            }
+
+            aboveBegin = rowBegin;
+            aboveEnd = rowEnd;
+            rowBegin = rowEnd;
+        }
+
+        // Only now can the frontier tell live neighbors from missing ones. Chunks
+        // surrounded on all sides cannot add anything to it.
+        for (Index index = 0; index < count; index++)
+            if (std::find(m_neighbors[index].begin(), m_neighbors[index].end(), Invalid) != m_neighbors[index].end())
+                extendFrontier(index);
+
+        m_laidOut = m_allocations;
+    }
+
     [[nodiscard]] constexpr Generation getGeneration() const
     {
         return m_generation;
@@ -332,79 +905,112 @@ public:
     {
         assert(generation > m_generation);
         m_generation = generation;
-        m_firstReusable = 0;
+        m_history = 0;
+        forgetChanges();
+        std::fill(m_taken.begin(), m_taken.end(), 0);
+        std::fill(m_onFrontier.begin(), m_onFrontier.end(), 0);
+        m_firstFree = 0;
         m_size = 0;
+        m_frontier.clear();
     }
 
     void clear()
     {
-        m_nodes.clear();
-        m_metas.clear();
+        m_chunks.clear();
+        m_previous.clear();
+        m_generations.clear();
+        m_activities.clear();
+        m_positions.clear();
+        m_neighbors.clear();
         m_map.clear();
+        m_blocks.clear();
+        m_frontier.clear();
+        m_history = 0;
+        forgetChanges();
+        m_taken.clear();
+        m_onFrontier.clear();
         m_generation = 1;
-        m_firstReusable = 0;
+        m_firstFree = 0;
+        m_laidOut = m_allocations;
         m_size = 0;
     }
 
     [[nodiscard]] constexpr const_iterator at(Index index) const
     {
-        if (index == Invalid)
+        if (!live(index))
             return end();
 
-        assert(index < m_nodes.size());
-
-        if (m_nodes[index].generation != m_generation)
-            return end();
+        return {this, index};
+    }
 
-        return {&m_nodes, &m_metas, m_generation, index};
+    [[nodiscard]] constexpr Index capacity() const
+    {
+        return static_cast<Index>(m_chunks.size());
     }
 
+    // Live chunks, including empty ones a tick keeps around while they are active.
     [[nodiscard]] constexpr size_t size() const
     {
         return m_size;
     }
 
-    BitBoard &operator|=(const BitBoard &other)
+    BasicBitBoard &operator|=(const BasicBitBoard &other)
     {
-        for (const auto &[otherNode, otherMeta] : other)
+        m_history = 0;
+
+        for (const auto &[otherChunk, otherPos] : other)
         {
-            if (auto entry = m_map.find(otherMeta.pos); entry != m_map.end())
+            if (auto entry = m_map.find(otherPos); entry != m_map.end())
             {
-                Node &node = m_nodes[entry->second];
+                Index index = entry->second;
 
-                if (node.generation == m_generation)
-                    node.chunk |= otherNode.chunk;
+                if (live(index))
+                {
+                    m_chunks[index] |= otherChunk;
+                }
                 else
-                    node.chunk = otherNode.chunk;
+                {
+                    m_chunks[index] = otherChunk;
+                    m_size++;
+                }
 
-                node.generation = m_generation;
+                m_generations[index] = m_generation;
+                m_activities[index] = Active;
+                take(index);
+                extendFrontier(index);
             }
             else
             {
-                allocate(otherNode.chunk, otherMeta.pos);
+                extendFrontier(allocate(otherChunk, otherPos));
             }
+
+            noteChange(otherPos);
         }
 
         return *this;
     }
 
-    BitBoard &operator-=(const BitBoard &other)
+    BasicBitBoard &operator-=(const BasicBitBoard &other)
     {
-        for (const auto &[otherNode, otherMeta] : other)
+        m_history = 0;
+
+        for (const auto &[otherChunk, otherPos] : other)
         {
-            if (auto entry = m_map.find(otherMeta.pos); entry != m_map.end())
+            if (auto entry = m_map.find(otherPos); entry != m_map.end())
             {
-                Node &node = m_nodes[entry->second];
+                Index index = entry->second;
 
-                if (node.generation == m_generation)
+                if (live(index))
                 {
-                    node.chunk -= otherNode.chunk;
+                    m_chunks[index] -= otherChunk;
 
-                    if (!node.chunk)
+                    if (!m_chunks[index])
                     {
-                        node.generation = 0;
+                        release(index);
                         m_size--;
                     }
+
+                    noteChange(otherPos);
                 }
             }
         }
@@ -412,35 +1018,17 @@ public:
         return *this;
     }
 
-    [[nodiscard]] friend BitBoard operator|(BitBoard lhs, const BitBoard &rhs)
+    [[nodiscard]] friend BasicBitBoard operator|(BasicBitBoard lhs, const BasicBitBoard &rhs)
     {
         lhs |= rhs;
         return lhs;
     }
 
-    [[nodiscard]] friend BitBoard operator-(BitBoard lhs, const BitBoard &rhs)
+    [[nodiscard]] friend BasicBitBoard operator-(BasicBitBoard lhs, const BasicBitBoard &rhs)
     {
         lhs -= rhs;
         return lhs;
     }
 };
 
-template <>
-struct std::tuple_size<BitBoard::const_iterator::reference> : std::integral_constant<std::size_t, 2>
-{
-};
-
-template <std::size_t I>
-struct std::tuple_element<I, BitBoard::const_iterator::reference>
-{
-    using type = std::tuple_element_t<I, std::tuple<const BitBoard::Node &, const BitBoard::Meta &>>;
-};
-
-template <std::size_t I>
-constexpr decltype(auto) get(BitBoard::const_iterator::reference proxy) noexcept
-{
-    if constexpr (I == 0)
-        return (proxy.node);
-    else if constexpr (I == 1)
-        return (proxy.meta);
-}
+using BitBoard = BasicBitBoard<Chunk>;
@@ -1,19 +1,74 @@
 #pragma once
 
 #include "BitBoard.hpp"
+#include "BoardMesh.hpp"
+#include "DensityPyramid.hpp"
 
 #include <SFML/Graphics/Color.hpp>
 #include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Rect.hpp>
 #include <SFML/Graphics/Transformable.hpp>
+#include <SFML/Graphics/VertexBuffer.hpp>
+#include <memory>
+#include <utility>
+#include <vector>
 
+// Draws the visible part of a board as one batch of triangles: textured rows of
+// its chunks up close, or the tiles of a density pyramid level when the chunks
+// would be too small to make out. The mesh lives on in a vertex buffer, where only
+// the chunks that changed since the last frame are uploaded again.
 class BitBoardRenderer : public sf::Transformable, public sf::Drawable
 {
 private:
-    const BitBoard &m_data;
+    BoardMesh m_mesh;
     sf::Color m_color;
+    std::shared_ptr<const BitBoard> m_board; // the published board the mesh was built from
+    BitBoard::ChunkPos m_min;                // and the chunks it covers
+    BitBoard::ChunkPos m_max;
+    unsigned int m_level = 0; // of the density pyramid, or 0 for the chunks themselves
+
+    sf::VertexBuffer m_buffer{sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Dynamic};
+    std::vector<size_t> m_uploads; // dirty slots of the mesh, sorted
+
+    // Copies what changed in the mesh to the vertex buffer, if there is one.
+    void upload();
+
+    // Chunks that overlap area, given in the coordinates of the render target.
+    [[nodiscard]] std::pair<BitBoard::ChunkPos, BitBoard::ChunkPos> chunksIn(sf::FloatRect area) const;
 
 public:
-    BitBoardRenderer(const BitBoard &data, sf::Color color) : m_data(data), m_color(color) {}
+    // Smallest side in pixels of what is drawn as a quad of its own.
+    static constexpr float MinimumPixels = 2.0F;
+
+    // The density pyramid level to draw at zoom, in world units per pixel, or 0 if
+    // the chunks are large enough to draw themselves.
+    [[nodiscard]] static unsigned int level(float zoom);
+
+    explicit BitBoardRenderer(sf::Color color) : m_color(color) {}
+
+    // Builds the mesh for the chunks of board that overlap area. A published board
+    // never changes, so the mesh is only rebuilt when a different board comes in
+    // or other chunks come into view. Holding on to the board keeps one more out
+    // of the pool.
+    void update(const std::shared_ptr<const BitBoard> &board, sf::FloatRect area);
+
+    // Builds the mesh from the tiles at level of density, the pyramid of board,
+    // that overlap area. Rebuilt under the same conditions as above.
+    void update(const std::shared_ptr<const BitBoard> &board, const DensityPyramid &density, unsigned int level, sf::FloatRect area);
+
+    // Updates the mesh from a board that may have changed in place.
+    void update(const BitBoard &board, sf::FloatRect area);
+
+    // The published board last drawn, if any.
+    [[nodiscard]] const std::shared_ptr<const BitBoard> &board() const
+    {
+        return m_board;
+    }
+
+    [[nodiscard]] const BoardMesh &mesh() const
+    {
+        return m_mesh;
+    }
 
     void draw(sf::RenderTarget &target, sf::RenderStates states) const override;
 };
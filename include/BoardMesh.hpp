@@ -0,0 +1,126 @@
+#pragma once
+
+#include "BitBoard.hpp"
+#include "Chunk.hpp"
+#include "DensityPyramid.hpp"
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <boost/unordered/unordered_flat_map.hpp>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Triangles that draw a board in a single call. Every non-empty row of a chunk is
+// one 8x1 quad, textured with the row of the 8x256 row texture whose pixels spell
+// out its bits. Only sf::Vertex is used, so meshes can be built and timed without
+// a window.
+//
+// A mesh kept up to date with update() instead gives every chunk a fixed slot of
+// VerticesPerChunk vertices, so that a new board only rewrites the slots of the
+// chunks that differ from the ones drawn. The slots written since clean() are
+// listed by dirty(), for uploading just those.
+//
+// Zoomed out, a mesh can instead hold one untextured quad per tile of a density
+// pyramid level, shaded by the share of its cells that are alive.
+class BoardMesh
+{
+public:
+    static constexpr size_t VerticesPerRow = 6;
+    static constexpr size_t VerticesPerChunk = 8 * VerticesPerRow;
+
+    // Opacity of a tile with a single live cell, so sparse patterns stay in sight.
+    static constexpr float MinimumShade = 0.25F;
+
+private:
+    struct Drawn
+    {
+        Chunk chunk;
+        size_t offset = 0; // of its slot in m_vertices
+        size_t frame = 0;  // the last update() that found it
+    };
+
+    std::vector<sf::Vertex> m_vertices;
+    size_t m_count = 0;
+
+    // Of update() only. A build() in between starts it over.
+    bool m_slotted = false;
+    sf::Color m_color;
+    size_t m_frame = 0;
+    boost::unordered::unordered_flat_map<BitBoard::ChunkPos, Drawn> m_drawn;
+    std::vector<size_t> m_free; // slots no chunk is drawn in, cleared to nothing
+
+    bool m_allDirty = true;
+    std::vector<size_t> m_dirty;
+
+    // Writes every row of chunk to the slot at offset, empty ones as nothing.
+    void write(size_t offset, const Chunk &chunk, sf::Vector2f origin, sf::Color color);
+    void reset();
+
+public:
+    // Replaces the mesh with one for every live chunk of board. The vertex storage
+    // is kept from one build to the next, so a steady board does not allocate.
+    void build(const BitBoard &board, sf::Color color);
+
+    // Like build(), for the live chunks with min <= position <= max only.
+    void build(const BitBoard &board, sf::Color color, BitBoard::ChunkPos min, BitBoard::ChunkPos max);
+
+    // Brings a mesh to the live chunks of board with min <= position <= max,
+    // rewriting only the slots of chunks that came into view or changed since the
+    // last update(), and clearing those of the ones gone. Once more than half of
+    // the slots are free, the mesh is laid out again from scratch.
+    void update(const BitBoard &board, sf::Color color, BitBoard::ChunkPos min, BitBoard::ChunkPos max);
+
+    // Replaces the mesh with one for the tiles at level of density that overlap the
+    // chunks with min <= position <= max.
+    void build(const DensityPyramid &density, unsigned int level, sf::Color color, BitBoard::ChunkPos min, BitBoard::ChunkPos max);
+
+    void clear()
+    {
+        m_count = 0;
+        m_slotted = false;
+        m_allDirty = true;
+    }
+
+    // Adds the rows of a chunk whose top left cell is at origin.
+    void append(const Chunk &chunk, sf::Vector2f origin, sf::Color color);
+
+    // Adds a square of side cells whose top left corner is at origin, with the
+    // opacity of color scaled by shade.
+    void appendTile(sf::Vector2f origin, float side, float shade, sf::Color color);
+
+    [[nodiscard]] const sf::Vertex *data() const
+    {
+        return m_vertices.data();
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_count;
+    }
+
+    // Whether the whole mesh changed since the last clean(), as it does on build().
+    [[nodiscard]] bool allDirty() const
+    {
+        return m_allDirty;
+    }
+
+    // Offsets of the slots rewritten since the last clean(), unless allDirty(), in
+    // no particular order and possibly more than once.
+    [[nodiscard]] const std::vector<size_t> &dirty() const
+    {
+        return m_dirty;
+    }
+
+    void clean()
+    {
+        m_allDirty = false;
+        m_dirty.clear();
+    }
+
+    [[nodiscard]] size_t bytes() const
+    {
+        return (m_vertices.capacity() * sizeof(sf::Vertex)) + (m_drawn.bucket_count() * (sizeof(std::pair<BitBoard::ChunkPos, Drawn>) + 1));
+    }
+};
@@ -1,17 +1,203 @@
 #pragma once
 
+#include "Direction.hpp"
+
 #include <SFML/System/Vector2.hpp>
+#include <array>
 #include <cassert>
 #include <cstdint>
+#include <type_traits>
 
-class Chunk
+// Square tile of N x N cells, stored as one word per row with bit x of row y being
+// the cell at (x, y). The 8x8 tile packs all of its rows into a single word and is
+// specialized below; it is the one the renderer, HashLife and the SIMD kernels use.
+template <unsigned int N>
+class BasicChunk
+{
+public:
+    static_assert(N == 16 || N == 32 || N == 64, "tiles are 8, 16, 32 or 64 cells wide");
+
+    using Row = std::conditional_t<N == 16, uint16_t, std::conditional_t<N == 32, uint32_t, uint64_t>>;
+
+    static constexpr unsigned int Size = N;
+
+private:
+    std::array<Row, N> m_rows{};
+
+public:
+    constexpr BasicChunk() = default;
+
+    [[nodiscard]] constexpr Row row(unsigned int y) const
+    {
+        assert(y < N);
+        return m_rows[y]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+
+    constexpr BasicChunk &setRow(unsigned int y, Row row)
+    {
+        assert(y < N);
+        m_rows[y] = row; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        return *this;
+    }
+
+    constexpr BasicChunk &set(sf::Vector2i pos, bool state)
+    {
+        assert(pos.x >= 0 && pos.x < static_cast<int>(N) && pos.y >= 0 && pos.y < static_cast<int>(N));
+        Row &row = m_rows[static_cast<unsigned int>(pos.y)]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        auto mask = static_cast<Row>(Row{1} << pos.x);
+        row = state ? static_cast<Row>(row | mask) : static_cast<Row>(row & ~mask);
+        return *this;
+    }
+
+    [[nodiscard]] constexpr bool get(sf::Vector2i pos) const
+    {
+        assert(pos.x >= 0 && pos.x < static_cast<int>(N) && pos.y >= 0 && pos.y < static_cast<int>(N));
+        return (m_rows[static_cast<unsigned int>(pos.y)] >> pos.x) & 1U; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+
+    // Cells that touch the neighbor in the given direction.
+    [[nodiscard]] static constexpr BasicChunk edge(Direction direction)
+    {
+        constexpr auto First = Row{1};
+        constexpr auto Last = static_cast<Row>(Row{1} << (N - 1));
+        constexpr auto Full = static_cast<Row>(~Row{0});
+
+        BasicChunk result;
+
+        switch (direction)
+        {
+        case Direction::North:
+            return result.setRow(0, Full);
+
+        case Direction::South:
+            return result.setRow(N - 1, Full);
+
+        case Direction::NorthWest:
+            return result.setRow(0, First);
+
+        case Direction::NorthEast:
+            return result.setRow(0, Last);
+
+        case Direction::SouthWest:
+            return result.setRow(N - 1, First);
+
+        case Direction::SouthEast:
+            return result.setRow(N - 1, Last);
+
+        default:
+            for (auto &row : result.m_rows)
+                row = direction == Direction::West ? First : Last;
+
+            return result;
+        }
+    }
+
+    constexpr explicit operator bool() const
+    {
+        for (auto row : m_rows)
+            if (row)
+                return true;
+
+        return false;
+    }
+
+    constexpr bool operator==(const BasicChunk &rhs) const = default;
+
+    constexpr BasicChunk &operator|=(const BasicChunk &other)
+    {
+        for (unsigned int y = 0; y < N; y++)
+            m_rows[y] |= other.m_rows[y]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+
+        return *this;
+    }
+
+    constexpr BasicChunk &operator&=(const BasicChunk &other)
+    {
+        for (unsigned int y = 0; y < N; y++)
+            m_rows[y] &= other.m_rows[y]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+
+        return *this;
+    }
+
+    constexpr BasicChunk &operator^=(const BasicChunk &other)
+    {
+        for (unsigned int y = 0; y < N; y++)
+            m_rows[y] ^= other.m_rows[y]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+
+        return *this;
+    }
+
+    constexpr BasicChunk &operator-=(const BasicChunk &other)
+    {
+        for (unsigned int y = 0; y < N; y++)
+            m_rows[y] &= static_cast<Row>(~other.m_rows[y]); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+
+        return *this;
+    }
+
+    [[nodiscard]] constexpr BasicChunk operator~() const
+    {
+        BasicChunk result;
+
+        for (unsigned int y = 0; y < N; y++)
+            result.m_rows[y] = static_cast<Row>(~m_rows[y]); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+
+        return result;
+    }
+
+    [[nodiscard]] constexpr friend BasicChunk operator|(BasicChunk lhs, const BasicChunk &rhs)
+    {
+        lhs |= rhs;
+        return lhs;
+    }
+
+    [[nodiscard]] constexpr friend BasicChunk operator&(BasicChunk lhs, const BasicChunk &rhs)
+    {
+        lhs &= rhs;
+        return lhs;
+    }
+
+    [[nodiscard]] constexpr friend BasicChunk operator^(BasicChunk lhs, const BasicChunk &rhs)
+    {
+        lhs ^= rhs;
+        return lhs;
+    }
+
+    [[nodiscard]] constexpr friend BasicChunk operator-(BasicChunk lhs, const BasicChunk &rhs)
+    {
+        lhs -= rhs;
+        return lhs;
+    }
+};
+
+template <>
+class BasicChunk<8>;
+
+using Chunk = BasicChunk<8>;
+
+template <>
+class BasicChunk<8>
 {
 private:
     uint64_t m_data;
 
+    // Cells that touch the neighbor in each direction, in Direction order.
+    static constexpr std::array<uint64_t, 8> Edges = {
+        0x00000000000000FFULL, // North
+        0xFF00000000000000ULL, // South
+        0x0101010101010101ULL, // West
+        0x8080808080808080ULL, // East
+        0x0000000000000001ULL, // NorthWest
+        0x0000000000000080ULL, // NorthEast
+        0x0100000000000000ULL, // SouthWest
+        0x8000000000000000ULL, // SouthEast
+    };
+
 public:
-    constexpr Chunk() : m_data(0) {}
-    explicit constexpr Chunk(uint64_t data) : m_data(data) {}
+    static constexpr unsigned int Size = 8;
+
+    constexpr BasicChunk() : m_data(0) {}
+    explicit constexpr BasicChunk(uint64_t data) : m_data(data) {}
 
     [[nodiscard]] constexpr uint64_t data() const
     {
@@ -34,6 +220,11 @@ public:
         return (m_data >> i) & 1;
     }
 
+    [[nodiscard]] static constexpr Chunk edge(Direction direction)
+    {
+        return Chunk(Edges[direction]); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+
     [[nodiscard]] constexpr Chunk shiftLeft() const
     {
         return Chunk((m_data >> 1) & 0x7F7F7F7F7F7F7F7FULL);
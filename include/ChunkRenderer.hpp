@@ -19,6 +19,12 @@ private:
 public:
     static void initializeSprites(Logger &logger);
 
+    // Row y holds the eight cells of a row whose bits are y, for BoardMesh texture coordinates.
+    [[nodiscard]] static const sf::Texture &rowTexture()
+    {
+        return m_texture;
+    }
+
     ChunkRenderer(Chunk data, sf::Color color) : m_data(data), m_color(color) {}
 
     void draw(sf::RenderTarget &target, sf::RenderStates states) const override;
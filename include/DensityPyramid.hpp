@@ -0,0 +1,84 @@
+#pragma once
+
+#include "BitBoard.hpp"
+
+#include <SFML/System/Vector2.hpp>
+#include <array>
+#include <boost/unordered/unordered_flat_map.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// Live cells per tile of 2^level by 2^level chunks, for every level from 1 up to
+// Levels, so that a board zoomed out too far to show its chunks can be drawn with
+// one quad per tile. Tiles without live cells are not stored.
+class DensityPyramid
+{
+public:
+    static constexpr unsigned int Levels = 10;
+
+    using TilePos = sf::Vector2i;
+
+private:
+    boost::unordered::unordered_flat_map<BitBoard::ChunkPos, uint32_t> m_counted;       // live cells per chunk
+    std::array<boost::unordered::unordered_flat_map<TilePos, uint32_t>, Levels> m_levels; // level 1 first
+    boost::unordered::unordered_flat_map<TilePos, int64_t> m_changes;                    // of the level being updated
+    boost::unordered::unordered_flat_map<TilePos, int64_t> m_nextChanges;                // of the one above
+    BitBoard::Generation m_generation = 0;
+
+    // Adds m_changes, given per level 1 tile, to every level.
+    void propagate();
+
+public:
+    // Counts the cells of board from scratch.
+    void rebuild(const BitBoard &board);
+
+    // Brings the pyramid to board, which has to come from the board it was last
+    // brought to by ticks and edits. Only the chunks in board.changes() are counted
+    // again, as long as that list reaches back to the last board; otherwise the
+    // whole board is.
+    void update(const BitBoard &board);
+
+    [[nodiscard]] BitBoard::Generation getGeneration() const
+    {
+        return m_generation;
+    }
+
+    // Cells in a tile at level, the most it can count.
+    [[nodiscard]] static constexpr uint64_t area(unsigned int level)
+    {
+        return uint64_t{Chunk::Size * Chunk::Size} << (2 * level);
+    }
+
+    // Calls visit(pos, population) for every tile at level that overlaps the chunks
+    // with min <= position <= max. Tile pos covers the chunks from pos * 2^level on.
+    // Like BitBoard::query(), the cost follows the size of the range or of the
+    // level, whichever is smaller.
+    template <typename Visit>
+    void query(unsigned int level, BitBoard::ChunkPos min, BitBoard::ChunkPos max, Visit &&visit) const
+    {
+        if (level < 1 || level > Levels || min.x > max.x || min.y > max.y)
+            return;
+
+        const auto &tiles = m_levels[level - 1];
+        const auto shift = static_cast<int>(level);
+        const TilePos first = {min.x >> shift, min.y >> shift};
+        const TilePos last = {max.x >> shift, max.y >> shift};
+        const auto tilesInRange = static_cast<uint64_t>((int64_t{last.x} - first.x + 1) * (int64_t{last.y} - first.y + 1));
+
+        if (tilesInRange <= tiles.size())
+        {
+            for (int y = first.y; y <= last.y; y++)
+                for (int x = first.x; x <= last.x; x++)
+                    if (auto entry = tiles.find({x, y}); entry != tiles.end())
+                        visit(entry->first, entry->second);
+        }
+        else
+        {
+            for (const auto &[pos, population] : tiles)
+                if (pos.x >= first.x && pos.x <= last.x && pos.y >= first.y && pos.y <= last.y)
+                    visit(pos, population);
+        }
+    }
+
+    [[nodiscard]] size_t bytes() const;
+};
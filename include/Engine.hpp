@@ -0,0 +1,81 @@
+#pragma once
+
+#include "BitBoard.hpp"
+#include "WorkerPool.hpp"
+#include "conway.hpp"
+#include "kernel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+class Engine
+{
+public:
+    Engine() = default;
+
+    Engine(const Engine &) = delete;
+    Engine &operator=(const Engine &) = delete;
+    Engine(Engine &&) = delete;
+    Engine &operator=(Engine &&) = delete;
+
+    virtual ~Engine() = default;
+
+    [[nodiscard]] virtual std::string_view name() const = 0;
+
+    // Writes the board 2^exponent generations after previous into current, along
+    // with the list of chunks that changed in between if the engine keeps one.
+    // State an engine keeps between calls is only used again when previous is the
+    // very object the last call wrote into, not a copy or a board swapped by value,
+    // so callers go back and forth between two boards by pointer.
+    virtual void advance(const BitBoard &previous, BitBoard &current, unsigned int exponent) = 0;
+
+    // Called when the board was changed outside of the engine, so any state kept
+    // between calls to advance() has to be rebuilt from the next board it is given.
+    virtual void invalidate() {}
+
+    // Chunks computed and skipped over all calls to advance(), for engines that count them.
+    [[nodiscard]] virtual conway::Counters counters() const
+    {
+        return {};
+    }
+};
+
+class BitBoardEngine : public Engine
+{
+private:
+    WorkerPool m_workers;
+    BitBoard m_scratch;
+    conway::Counters m_counters;
+    kernel::Rule m_rule;
+
+public:
+    // Every generation is ticked one at a time, so 2^MaxStep of them is the most
+    // one advance() is asked to do.
+    static constexpr unsigned int MaxStep = 16;
+
+    BitBoardEngine(size_t threads, const kernel::Rule &rule) : m_workers(threads), m_rule(rule) {}
+
+    [[nodiscard]] std::string_view name() const override
+    {
+        return "bitboard";
+    }
+
+    void advance(const BitBoard &previous, BitBoard &current, unsigned int exponent) override;
+
+    [[nodiscard]] conway::Counters counters() const override
+    {
+        return m_counters;
+    }
+};
+
+enum class EngineType : uint8_t
+{
+    BitBoard = 0,
+    HashLife,
+};
+
+[[nodiscard]] std::optional<EngineType> parseEngine(std::string_view name);
+[[nodiscard]] std::unique_ptr<Engine> makeEngine(EngineType type, size_t threads, const kernel::Rule &rule);
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "BitBoard.hpp"
+#include "Engine.hpp"
+#include "kernel.hpp"
+
+#include <array>
+#include <boost/unordered/unordered_flat_map.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Gosper's HashLife over a hash-consed quadtree. Leaves are 8x8 chunks at level 3,
+// and a node at level L covers 2^L x 2^L cells. Every node memoizes its centre
+// half advanced in time, so repeating patterns are only ever computed once.
+class HashLife : public Engine
+{
+public:
+    using NodeId = uint32_t;
+
+    static constexpr NodeId None = std::numeric_limits<NodeId>::max();
+
+    // Above this many nodes the tree is rebuilt from the current root, dropping memoized results.
+    static constexpr size_t GarbageThreshold = 1 << 23;
+
+private:
+    struct Node
+    {
+        std::array<NodeId, 4> children = {None, None, None, None}; // north west, north east, south west, south east
+        uint64_t leaf = 0;
+        uint64_t population = 0;
+        NodeId result = None;
+        uint8_t level = 3;
+        uint8_t resultExponent = 0;
+    };
+
+    struct ChildrenHash
+    {
+        std::size_t operator()(const std::array<NodeId, 4> &children) const
+        {
+            uint64_t a = (static_cast<uint64_t>(children[0]) << 32) | children[1];
+            uint64_t b = (static_cast<uint64_t>(children[2]) << 32) | children[3];
+            uint64_t h = (a * 0x9E3779B97F4A7C15ULL) ^ (b + 0x632BE59BD9B4E019ULL + (a << 6) + (a >> 2));
+            return h ^ (h >> 29);
+        }
+    };
+
+    std::vector<Node> m_nodes;
+    boost::unordered::unordered_flat_map<uint64_t, NodeId> m_leaves;
+    boost::unordered::unordered_flat_map<std::array<NodeId, 4>, NodeId, ChildrenHash> m_branches;
+    std::vector<NodeId> m_empty;
+
+    NodeId m_root = None;
+    int64_t m_originX = 0; // chunk position of the root's north west corner
+    int64_t m_originY = 0;
+    uint64_t m_generation = 0;
+    kernel::Rule m_rule;
+
+    const BitBoard *m_exported = nullptr;
+    BitBoard::Generation m_exportedGeneration = 0;
+
+    NodeId leaf(uint64_t data);
+    NodeId join(NodeId northWest, NodeId northEast, NodeId southWest, NodeId southEast);
+    NodeId empty(unsigned int level);
+    NodeId centre(NodeId id);
+    NodeId expand(NodeId id);
+    NodeId successor(NodeId id, unsigned int exponent);
+    NodeId build(unsigned int level, int64_t x, int64_t y, std::pair<BitBoard::ChunkPos, uint64_t> *first, std::pair<BitBoard::ChunkPos, uint64_t> *last);
+    void collect(NodeId id, int64_t x, int64_t y, std::vector<std::pair<BitBoard::ChunkPos, uint64_t>> &chunks) const;
+    void reset();
+    void load(std::vector<std::pair<BitBoard::ChunkPos, uint64_t>> chunks);
+    void collectGarbage();
+
+public:
+    // Memoized results only hold for the rule they were computed under, so the rule
+    // is fixed for the lifetime of the engine.
+    explicit HashLife(const kernel::Rule &rule = kernel::Conway) : m_rule(rule) {}
+
+    [[nodiscard]] std::string_view name() const override
+    {
+        return "hashlife";
+    }
+
+    // Writes the whole board out every time, which only pays off for large exponents.
+    void advance(const BitBoard &previous, BitBoard &current, unsigned int exponent) override;
+
+    void invalidate() override
+    {
+        m_exported = nullptr;
+    }
+
+    // Replaces the universe with the live chunks of board.
+    void load(const BitBoard &board);
+
+    // Writes the live chunks of the universe into board, which must be empty for its generation.
+    void store(BitBoard &board) const;
+
+    // Advances the universe by 2^exponent generations.
+    void step(unsigned int exponent);
+
+    [[nodiscard]] uint64_t population() const
+    {
+        return m_root == None ? 0 : m_nodes[m_root].population;
+    }
+
+    // Generations advanced since the last load().
+    [[nodiscard]] uint64_t generation() const
+    {
+        return m_generation;
+    }
+
+    [[nodiscard]] size_t nodeCount() const
+    {
+        return m_nodes.size();
+    }
+};
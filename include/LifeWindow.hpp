@@ -0,0 +1,40 @@
+#pragma once
+
+#include "BitBoard.hpp"
+#include "BitBoardRenderer.hpp"
+#include "Engine.hpp"
+#include "Logger.hpp"
+#include "Options.hpp"
+#include "Simulation.hpp"
+#include "Window.hpp"
+
+#include <SFML/Graphics/Color.hpp>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+class LifeWindow : public Window
+{
+protected:
+    std::shared_ptr<Simulation> simulation;
+    BitBoard drawBuffer;
+    BitBoardRenderer boardRenderer{CellColor};
+    BitBoardRenderer bufferRenderer{CellColor};
+    std::optional<std::string> savePath;
+    uint64_t jump;
+
+    void initialize() override;
+    void deinitialize() override;
+
+    void update() override;
+    void draw() override;
+    [[nodiscard]] bool changed() override;
+
+public:
+    static constexpr sf::Color BackgroundColor = sf::Color::Black;
+    static constexpr sf::Color PausedColor = sf::Color(32, 32, 32);
+    static constexpr sf::Color CellColor = sf::Color::White;
+
+    LifeWindow(Logger &logger, unsigned int width, unsigned int height, std::unique_ptr<Engine> engine, BitBoard board, const Options &options);
+};
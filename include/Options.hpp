@@ -1,11 +1,16 @@
 #pragma once
 
+#include "Engine.hpp"
 #include "Logger.hpp"
+#include "kernel.hpp"
 
+#include <cstdint>
 #include <exception>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 constexpr std::string_view CONWAY_VERSION_STRING = "1.0.0";
 
@@ -20,6 +25,26 @@ public:
     bool info = false;
     bool debug = false;
     bool benchmark = false;
+    bool compareTiles = false;
+    bool json = false;
+    unsigned int threads;
+    std::optional<kernel::Variant> kernel;
+    EngineType engine = EngineType::BitBoard;
+    kernel::Rule rule;
+    unsigned int step = 0;
+    unsigned int rate = 0; // generations per second, 0 for no limit
+    uint64_t jump = 1'000; // generations, for Shift+Right
+    std::vector<std::string> workloads; // every built-in one if empty
+    unsigned int generations = 1'000;
+    unsigned int warmup = 1;
+    unsigned int trials = 5;
+    std::vector<std::string> patterns;
+    std::optional<std::string> snapshot; // loaded before the patterns
+    std::optional<std::string> save;
+    std::optional<uint64_t> run; // generations to run without a window
+    std::optional<std::string> checkpoint;
+    unsigned int checkpointGenerations = 0;
+    unsigned int checkpointSeconds = 600;
 
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays, cppcoreguidelines-pro-bounds-pointer-arithmetic, modernize-avoid-c-arrays)
     Options(int argc, char *argv[]);
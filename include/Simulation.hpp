@@ -1,50 +1,215 @@
 #pragma once
 
 #include "BitBoard.hpp"
+#include "DensityPyramid.hpp"
+#include "Engine.hpp"
 #include "Logger.hpp"
+#include "conway.hpp"
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <string>
 #include <thread>
 #include <utility>
 #include <vector>
 
 class Simulation : public std::enable_shared_from_this<Simulation>
 {
+public:
+    // Checkpoints written so far. The last ones describe the most recent checkpoint.
+    struct CheckpointStats
+    {
+        size_t written = 0;
+        size_t failed = 0;
+        size_t lastBytes = 0;
+        size_t totalBytes = 0;
+        double lastMilliseconds = 0.0;
+        double totalMilliseconds = 0.0;
+    };
+
+    // Where the ticking thread spent its time since start(). Steps run as tasks
+    // count as both.
+    struct Stats
+    {
+        size_t advances = 0; // of 2^step generations each, or fewer at the end of a scheduleAdvance()
+        uint64_t generations = 0;
+        size_t published = 0; // boards, which frames only get when they ask for one
+        size_t tasks = 0;
+        size_t edits = 0;  // passes over the board that applied scheduleModify() edits
+        size_t copies = 0; // of them, the ones that had to copy the whole board first
+        size_t spares = 0; // copies of the board made while waiting, ahead of edits
+        uint64_t editLatencyNanoseconds = 0;    // from scheduling the first edit of a pass to publishing it
+        uint64_t maxEditLatencyNanoseconds = 0; // of a single pass
+        uint64_t advanceNanoseconds = 0;
+        uint64_t publishNanoseconds = 0;
+        uint64_t densityNanoseconds = 0;
+        uint64_t taskNanoseconds = 0;
+        conway::Counters engine; // as reported by the engine, for those that count
+    };
+
+    // How often the ticking thread logs its stats at the info level.
+    static constexpr std::chrono::seconds ReportInterval{10};
+
+    // Edits go along with the next tick while ticks take less than this, which gets
+    // them on screen within a frame at 60 Hz. After slower ticks they are published
+    // on their own first. Edits made during a tick that runs longer than this do
+    // not wait for it: the edit thread publishes them on a spare meanwhile.
+    static constexpr std::chrono::milliseconds EditBudget{8};
+
 private:
     std::thread m_thread;
+    std::unique_ptr<Engine> m_engine;
+    unsigned int m_step;
 
     std::atomic<std::shared_ptr<const BitBoard>> m_data;
 
+    using Edit = std::function<void(BitBoard &)>;
+
+    // Either a task that returns the board to publish, or an edit. Edits at the
+    // front of the queue are taken along by a tick that is running when they come,
+    // or by the edit thread once that tick has run for EditBudget.
+    struct Task
+    {
+        std::function<std::shared_ptr<const BitBoard>()> run = {};
+        Edit edit = {};
+        std::chrono::steady_clock::time_point scheduled = {};
+    };
+
     bool m_running = true;
     bool m_paused = false;
-    std::queue<std::function<std::shared_ptr<const BitBoard>()>> m_taskQueue;
+    uint64_t m_advanceLeft = 0; // generations that scheduleAdvance() still has to go
+    double m_targetRate = 0.0;  // generations per second while running, 0 for no limit
+    std::chrono::steady_clock::time_point m_nextTick;
+    std::queue<Task> m_taskQueue;
     std::mutex m_tickingMutex;
     std::condition_variable m_tickingCondition;
 
+    // Edits are applied as a delta, touched by the ticking thread only. While
+    // running, they wait for the next tick, which applies them to the board it
+    // produces. Otherwise they go to a spare: a board published earlier, which only
+    // misses the edits logged since. A tick leaves no spare behind, so while the
+    // board is being edited, or paused, the thread copies the published board into
+    // one before it waits; the edits that end the wait do not pay for that copy.
+    struct Spare
+    {
+        std::shared_ptr<BitBoard> board;
+        size_t edits = 0; // of the log applied to it
+
+        // Boards drawn or checkpointed a moment ago are still in use; any other
+        // spare is only held here.
+        [[nodiscard]] bool free() const
+        {
+            return board.use_count() == 1;
+        }
+    };
+
+    static constexpr size_t Spares = 3;
+
+    // Between frames the ticking thread runs ahead of the published board, going
+    // back and forth between two boards of its own. Only the boards that frames
+    // ask for are published, so a tick costs neither a pooled board nor a swap of
+    // m_data, however many ticks a frame takes.
+    std::shared_ptr<BitBoard> m_ahead; // the newest board, while it is not published
+    std::shared_ptr<BitBoard> m_next;  // the one the next tick writes into, if free
+    std::atomic<bool> m_wanted{true};  // snapshot() was called since the last publish
+
+    std::vector<Edit> m_deferred;
+    std::chrono::steady_clock::time_point m_deferredSince; // when the first of them was scheduled
+    std::chrono::steady_clock::duration m_lastAdvance{};  // how long the last tick took
+    std::shared_ptr<BitBoard> m_latest; // the published board, if it came from the ticking thread
+    std::vector<Spare> m_spares;        // oldest first
+    bool m_spareWanted = false;         // edits were applied since a spare was last prepared
+    std::vector<Edit> m_editLog;        // that took the spares to m_latest, from m_editBase on
+    size_t m_editBase = 0;
+
+    // The second lane for edits. While the engine is busy with a tick, the ticking
+    // thread touches none of the edit state above, so the edit thread can take over
+    // a tick that outlasts EditBudget: it applies the edits queued meanwhile like
+    // the ticking thread would while paused, and publishes them. The tick then
+    // waits for a pass under way and replays the edits into its own board.
+    std::thread m_editThread;
+    bool m_ticking = false; // under m_tickingMutex, along with the time it started
+    std::chrono::steady_clock::time_point m_tickStarted;
+    std::vector<Edit> m_laneEdits; // published during the tick, for it to replay
+    std::mutex m_laneMutex;        // held by the edit thread for each pass
+
     std::vector<std::unique_ptr<BitBoard>> m_pool;
+    size_t m_epoch = 0; // bumped by clear(), so boards acquired before it are not pooled again
     std::mutex m_poolMutex;
 
+    // Kept in step with the published board while tracked, for drawing it zoomed
+    // out. Otherwise it falls behind, and is counted again when next read.
+    std::atomic<bool> m_densityTracked = false; // also read by ticks, without the lock
+    DensityPyramid m_density;
+    uint64_t m_published = 1;      // boards published so far, the first one included
+    uint64_t m_densityVersion = 0; // the one of them m_density counts
+    std::mutex m_densityMutex;
+
     std::exception_ptr m_exception;
     std::mutex m_exceptionMutex;
 
+    Stats m_stats;
+    Stats m_reported; // m_stats as of the last report, touched by the ticking thread only
+    std::chrono::steady_clock::time_point m_lastReport;
+    std::mutex m_statsMutex;
+
+    // Checkpoints are written by their own thread from a board pinned by the ticking
+    // thread. Only one board is pinned at a time, so the pool grows by one at most.
+    std::string m_checkpointPath;
+    uint64_t m_checkpointGenerations = 0; // 0 turns the generation trigger off
+    std::chrono::steady_clock::duration m_checkpointInterval{};
+    uint64_t m_sinceCheckpoint = 0; // generations, touched by the ticking thread only
+    std::chrono::steady_clock::time_point m_lastCheckpoint;
+    std::thread m_checkpointThread;
+    std::shared_ptr<const BitBoard> m_checkpointBoard;
+    bool m_checkpointBusy = false; // from handing a board over until it is written
+    bool m_checkpointRunning = true;
+    CheckpointStats m_checkpointStats;
+    std::mutex m_checkpointMutex;
+    std::condition_variable m_checkpointCondition;
+
     [[nodiscard]] std::shared_ptr<BitBoard> acquire();
     void clear();
+    bool advance(unsigned int exponent);
+    void publishAhead();
+
+    [[nodiscard]] std::shared_ptr<BitBoard> applyEdits(const std::vector<Edit> &edits);
+    void mergeEdits(BitBoard &board);
+    void defer(const Edit &edit, std::chrono::steady_clock::time_point scheduled);
+    void publishEdits();
+    void recordEditLatency();
+    void forgetEdits(std::shared_ptr<BitBoard> latest);
+    [[nodiscard]] bool spareFree() const;
+    void prepareSpare();
+
+    void publish(const std::shared_ptr<const BitBoard> &board);
+    void updateDensity(const BitBoard &board);
+    void catchUpDensity();
+    void report();
 
     void tickingThread();
-    void pushTask(const std::function<std::shared_ptr<const BitBoard>()> &task);
+    void editThread();
+    void publishLaneEdits();
+    void checkpointThread();
+    [[nodiscard]] bool checkpointDue(std::chrono::steady_clock::time_point now);
+    void offerCheckpoint(const std::shared_ptr<const BitBoard> &board);
+    void pushTask(Task task);
 
 protected:
     Logger &logger;
 
 public:
-    Simulation(Logger &logger) : m_data(std::make_shared<const BitBoard>()), logger(logger) {}
-    Simulation(Logger &logger, BitBoard data) : m_data(std::make_shared<const BitBoard>(std::move(data))), logger(logger) {}
+    // Every tick advances the board by 2^step generations using engine.
+    Simulation(Logger &logger, std::unique_ptr<Engine> engine, unsigned int step = 0) : m_engine(std::move(engine)), m_step(step), m_data(std::make_shared<const BitBoard>()), logger(logger) {}
+    Simulation(Logger &logger, std::unique_ptr<Engine> engine, BitBoard data, unsigned int step = 0) : m_engine(std::move(engine)), m_step(step), m_data(std::make_shared<const BitBoard>(std::move(data))), logger(logger) {}
 
     Simulation(const Simulation &) = delete;
     Simulation &operator=(const Simulation &) = delete;
@@ -56,15 +221,69 @@ public:
     void start();
     bool togglePause();
     void scheduleStep();
+
+    // Advances the board by generations as fast as the engine goes, paused or not,
+    // in ticks of at most 2^step generations. Frames get the boards they ask for on
+    // the way, and the last one.
+    void scheduleAdvance(uint64_t generations);
+
+    // Ticks at most generationsPerSecond while running; 0 lifts the limit, which is
+    // the default. Does not slow down scheduleAdvance().
+    void setTargetRate(double generationsPerSecond);
+
+    // Applies func to the board. Its cost follows what func touches rather than the
+    // size of the board; see m_deferred. Edits go ahead of ticks but not of other
+    // tasks, and all the edits waiting are applied in a single pass.
     void scheduleModify(std::function<void(BitBoard &)> func);
     void scheduleClear();
+
+    // Writes the board, after every task scheduled before, to a snapshot file.
+    // Failures are logged and leave the simulation running.
+    void scheduleSave(std::string path);
+
+    // Replaces the board with the one in a snapshot file. A file that cannot be
+    // loaded is logged and leaves the board as it was.
+    void scheduleLoad(std::string path);
+
+    // Writes a checkpoint to path whenever generations have passed or interval has
+    // elapsed since the last one; a zero turns that trigger off. Checkpoints due
+    // while one is still being written wait for it. Call before start().
+    void enableCheckpoints(std::string path, uint64_t generations, std::chrono::seconds interval);
+
+    // Whether the ticking thread keeps the density pyramid in step with every board
+    // it publishes. Worth it only while the pyramid is read every frame.
+    void trackDensity(bool tracked);
     void stop();
 
+    // Also asks the ticking thread to publish the next board it has.
     [[nodiscard]] std::shared_ptr<const BitBoard> snapshot()
     {
+        m_wanted.store(true, std::memory_order_relaxed);
         return m_data.load();
     }
 
+    // Calls read with the density pyramid of the latest published board, or of one
+    // about to be published. The ticking thread waits until read returns.
+    template <typename Read>
+    void readDensity(Read &&read)
+    {
+        std::scoped_lock lock(m_densityMutex);
+        catchUpDensity();
+        read(std::as_const(m_density));
+    }
+
+    [[nodiscard]] Stats stats()
+    {
+        std::scoped_lock lock(m_statsMutex);
+        return m_stats;
+    }
+
+    [[nodiscard]] CheckpointStats checkpointStats()
+    {
+        std::scoped_lock lock(m_checkpointMutex);
+        return m_checkpointStats;
+    }
+
     [[nodiscard]] std::exception_ptr exception()
     {
         std::scoped_lock lock(m_exceptionMutex);
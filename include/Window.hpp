@@ -3,8 +3,10 @@
 #include "Logger.hpp"
 
 #include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Rect.hpp>
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/View.hpp>
+#include <SFML/System/Time.hpp>
 #include <SFML/System/Vector2.hpp>
 #include <SFML/Window/Event.hpp>
 #include <functional>
@@ -17,6 +19,8 @@ class Window
 private:
     std::vector<std::function<void(const sf::Event &)>> m_handlers;
 
+    void handle(const sf::Event &event);
+
 protected:
     Logger &logger;
 
@@ -40,13 +44,36 @@ protected:
         });
     }
 
+    // World units per pixel of the window.
+    [[nodiscard]] float zoom() const
+    {
+        return view.getSize().x / static_cast<float>(size.x);
+    }
+
+    // The part of the world the view shows. The view is never rotated.
+    [[nodiscard]] sf::FloatRect visibleArea() const
+    {
+        return {view.getCenter() - (view.getSize() / 2.0F), view.getSize()};
+    }
+
     virtual void initialize() = 0;
     virtual void deinitialize() = 0;
 
     virtual void update() = 0;
     virtual void draw() = 0;
 
+    // Whether draw() would show something else than the last frame did. Frames
+    // after an event are always drawn.
+    [[nodiscard]] virtual bool changed() = 0;
+
 public:
+    static constexpr float MinZoom = 1.0F / 64.0F;
+    static constexpr float MaxZoom = 1024.0F;
+
+    // How long the event loop sleeps between checks for a change, while there is
+    // nothing new to draw.
+    static constexpr sf::Time IdleWait = sf::milliseconds(4);
+
     Window(Logger &logger, unsigned int width, unsigned int height, const std::string &title, sf::Color background);
 
     Window(const Window &) = delete;
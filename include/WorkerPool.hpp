@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool
+{
+private:
+    std::vector<std::thread> m_threads;
+
+    const std::function<void(size_t)> *m_job = nullptr;
+    size_t m_epoch = 0;
+    size_t m_pending = 0;
+    bool m_running = true;
+    std::mutex m_mutex;
+    std::condition_variable m_startCondition;
+    std::condition_variable m_doneCondition;
+
+    std::exception_ptr m_exception;
+
+    void workerThread(size_t worker);
+
+public:
+    explicit WorkerPool(size_t count);
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+    WorkerPool(WorkerPool &&) = delete;
+    WorkerPool &operator=(WorkerPool &&) = delete;
+
+    ~WorkerPool();
+
+    // Number of workers, including the thread calling run().
+    [[nodiscard]] size_t size() const
+    {
+        return m_threads.size() + 1;
+    }
+
+    // Runs job(worker) once on every worker and blocks until all of them are done.
+    void run(const std::function<void(size_t)> &job);
+
+    // Splits [0, count) into even per-worker ranges handed out in blocks of `grain`.
+    // Workers that drain their own range steal blocks from the others, so dense
+    // regions don't leave a single worker behind.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t, size_t)> &body);
+};
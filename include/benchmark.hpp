@@ -0,0 +1,91 @@
+#pragma once
+
+#include "BitBoard.hpp"
+#include "Engine.hpp"
+#include "Logger.hpp"
+#include "conway.hpp"
+#include "kernel.hpp"
+
+#include <SFML/System/Vector2.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Named starting boards for --benchmark, and the timings taken on them.
+namespace benchmark
+{
+    struct Workload
+    {
+        std::string name;
+        std::string description;
+        std::function<void(BitBoard &)> seed;
+    };
+
+    // Every built-in workload, in the order the suite runs them.
+    [[nodiscard]] const std::vector<Workload> &workloads();
+
+    [[nodiscard]] const Workload *find(std::string_view name);
+
+    struct Settings
+    {
+        EngineType engine = EngineType::BitBoard;
+        size_t threads = 1;
+        unsigned int step = 0;
+        unsigned int generations = 1'000; // advances per trial, each of 2^step generations
+        unsigned int warmup = 1;          // untimed trials before the timed ones
+        unsigned int trials = 5;
+        kernel::Rule rule;
+    };
+
+    struct Result
+    {
+        std::string workload;
+        std::string_view engine;
+        std::vector<double> milliseconds; // one per timed trial, in the order they ran
+        double median = 0.0;
+        double p95 = 0.0;
+        double generationsPerSecond = 0.0; // at the median
+        size_t chunks = 0;                 // live chunks at the end of the last trial
+        size_t bytes = 0;                  // held by the board at the end of the last trial
+        conway::Counters counters;         // of the last trial
+        BitBoard board;                    // at the end of the last trial
+    };
+
+    // Every trial starts from a freshly seeded board and a fresh engine, so caches
+    // kept by an engine between calls do not carry over from one trial to the next.
+    [[nodiscard]] Result run(const Workload &workload, const Settings &settings, Logger &logger);
+
+    void writeText(std::ostream &out, const Settings &settings, const std::vector<Result> &results);
+    void writeJson(std::ostream &out, const Settings &settings, const std::vector<Result> &results);
+
+    // Random square of the given side with about density of its cells alive.
+    template <typename Board>
+    void seedSoup(Board &board, double density, int extent = 512, unsigned int seed = 1)
+    {
+        std::mt19937 random(seed);
+        std::bernoulli_distribution alive(density);
+
+        for (int y = 0; y < extent; y++)
+            for (int x = 0; x < extent; x++)
+                if (alive(random))
+                    board.set({x, y}, true);
+    }
+
+    // Gliders far apart from each other, so almost every chunk is mostly empty.
+    template <typename Board>
+    void seedGliders(Board &board, int count = 32, int spacing = 96)
+    {
+        constexpr std::array<sf::Vector2i, 5> Glider = {{{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}}};
+
+        for (int y = 0; y < count; y++)
+            for (int x = 0; x < count; x++)
+                for (auto cell : Glider)
+                    board.set(cell + sf::Vector2i(x * spacing, y * spacing), true);
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "BitBoard.hpp"
+#include "Logger.hpp"
+#include "Options.hpp"
+
+// What the executable does besides opening a window. None of it needs a display,
+// so the headless build is made of these alone.
+namespace commands
+{
+    // The snapshot given on the command line, if any, with every pattern on top.
+    [[nodiscard]] BitBoard loadBoard(const Options &options, Logger &logger);
+
+    void runBenchmark(const Options &options, Logger &logger);
+
+    // Times the bitboard tick on a dense and a sparse built-in board for every tile
+    // size, which the benchmark options do not apply to.
+    void compareTileSizes(const Options &options, Logger &logger);
+
+    // Advances the loaded board by --run generations and prints its population,
+    // saving it afterwards if --save is given.
+    void runHeadless(const Options &options, Logger &logger);
+}
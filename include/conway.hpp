@@ -1,8 +1,121 @@
 #pragma once
 
 #include "BitBoard.hpp"
+#include "WorkerPool.hpp"
+#include "kernel.hpp"
+
+#include <cstddef>
+#include <cstdint>
 
 namespace conway
 {
-    void tick(const BitBoard &previous, BitBoard &current);
+    // Nanoseconds spent in each phase of a tick: evolving live chunks, evolving
+    // birth candidates from the frontier, writing results back into slots they
+    // already had, inserting the ones that needed a slot allocated, collecting the
+    // next frontier, and re-sorting the slots when allocation scattered them.
+    struct Timings
+    {
+        uint64_t live = 0;
+        uint64_t candidates = 0;
+        uint64_t writeBack = 0;
+        uint64_t insert = 0;
+        uint64_t frontier = 0;
+        uint64_t relayout = 0;
+
+        [[nodiscard]] constexpr uint64_t total() const
+        {
+            return live + candidates + writeBack + insert + frontier + relayout;
+        }
+
+        constexpr Timings &operator+=(const Timings &other)
+        {
+            live += other.live;
+            candidates += other.candidates;
+            writeBack += other.writeBack;
+            insert += other.insert;
+            frontier += other.frontier;
+            relayout += other.relayout;
+            return *this;
+        }
+
+        constexpr Timings &operator-=(const Timings &other)
+        {
+            live -= other.live;
+            candidates -= other.candidates;
+            writeBack -= other.writeBack;
+            insert -= other.insert;
+            frontier -= other.frontier;
+            relayout -= other.relayout;
+            return *this;
+        }
+    };
+
+    // Chunks a tick went through: computed ones ran through the adder network,
+    // skipped ones were copied forward because their neighbourhood had settled.
+    // Together they are the live chunks and the birth candidates taken from the
+    // frontier. Births and deaths count chunks that became non-empty or empty.
+    // Allocated counts the slots the tick had to hand out for new chunks and
+    // frontier positions, probes the bitmap words it looked at to find them, and
+    // lookups the queries of the position map.
+    //
+    // Everything is counted per worker and timed per phase, never per chunk, so
+    // keeping these always on costs nothing measurable.
+    struct Counters
+    {
+        size_t computed = 0;
+        size_t skipped = 0;
+        size_t live = 0;
+        size_t candidates = 0;
+        size_t births = 0;
+        size_t deaths = 0;
+        size_t allocated = 0;
+        size_t probes = 0;
+        size_t lookups = 0;
+        Timings nanoseconds;
+
+        constexpr Counters &operator+=(const Counters &other)
+        {
+            computed += other.computed;
+            skipped += other.skipped;
+            live += other.live;
+            candidates += other.candidates;
+            births += other.births;
+            deaths += other.deaths;
+            allocated += other.allocated;
+            probes += other.probes;
+            lookups += other.lookups;
+            nanoseconds += other.nanoseconds;
+            return *this;
+        }
+
+        constexpr Counters &operator-=(const Counters &other)
+        {
+            computed -= other.computed;
+            skipped -= other.skipped;
+            live -= other.live;
+            candidates -= other.candidates;
+            births -= other.births;
+            deaths -= other.deaths;
+            allocated -= other.allocated;
+            probes -= other.probes;
+            lookups -= other.lookups;
+            nanoseconds -= other.nanoseconds;
+            return *this;
+        }
+
+        [[nodiscard]] constexpr friend Counters operator-(Counters lhs, const Counters &rhs)
+        {
+            lhs -= rhs;
+            return lhs;
+        }
+    };
+
+    // The rule must not have B0: an empty chunk has to stay empty, or the board
+    // would not stay finite.
+    Counters tick(const BitBoard &previous, BitBoard &current, const kernel::Rule &rule = kernel::Conway);
+
+    // Defined for 8x8, 16x16, 32x32 and 64x64 tiles. The 8x8 board goes
+    // through the batched SIMD kernel; larger tiles are evolved a row at a time.
+    template <typename ChunkT>
+    Counters tick(const BasicBitBoard<ChunkT> &previous, BasicBitBoard<ChunkT> &current, WorkerPool &pool, const kernel::Rule &rule);
 }
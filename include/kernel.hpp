@@ -0,0 +1,315 @@
+#pragma once
+
+#include "Direction.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+namespace kernel
+{
+    // Chunk words of up to Capacity 3x3 neighbourhoods. Each neighbourhood position
+    // has its own contiguous array, so consecutive lanes load straight into vector
+    // registers. Neighbours are indexed by Direction, the chunk itself by Center.
+    struct Batch
+    {
+        static constexpr size_t Capacity = 128;
+        static constexpr size_t Center = 8;
+
+        std::array<std::array<uint64_t, Capacity>, 9> words{};
+        size_t size = 0;
+    };
+
+    using Results = std::array<uint64_t, Batch::Capacity>;
+
+    // An outer-totalistic rule in B/S notation: bit n of birth is set when a dead
+    // cell with n live neighbours comes alive, bit n of survival when a live cell
+    // with n live neighbours stays alive.
+    struct Rule
+    {
+        uint16_t birth = 1U << 3;
+        uint16_t survival = 1U << 2 | 1U << 3;
+
+        [[nodiscard]] constexpr bool operator==(const Rule &) const = default;
+    };
+
+    constexpr Rule Conway;
+
+    // Rules the kernels are compiled for one by one. Any other rule goes through a
+    // generic comparison that costs a few operations per count the rule mentions.
+    constexpr std::array<Rule, 9> Specialized = {{
+        Conway,
+        {1U << 3 | 1U << 6, 1U << 2 | 1U << 3},                                                // B36/S23, HighLife
+        {1U << 3 | 1U << 6 | 1U << 7 | 1U << 8, 1U << 3 | 1U << 4 | 1U << 6 | 1U << 7 | 1U << 8}, // B3678/S34678, Day & Night
+        {1U << 2, 0},                                                                          // B2/S, Seeds
+        {1U << 3, 0x1FF},                                                                      // B3/S012345678, Life without Death
+        {1U << 3 | 1U << 6, 1U << 1 | 1U << 2 | 1U << 5},                                      // B36/S125, 2x2
+        {1U << 3 | 1U << 6 | 1U << 8, 1U << 2 | 1U << 4 | 1U << 5},                            // B368/S245, Morley
+        {1U << 3, 1U << 1 | 1U << 2 | 1U << 3 | 1U << 4 | 1U << 5},                            // B3/S12345, Maze
+        {1U << 1 | 1U << 3 | 1U << 5 | 1U << 7, 1U << 1 | 1U << 3 | 1U << 5 | 1U << 7},         // B1357/S1357, Replicator
+    }};
+
+    // Reads "B36/S23", the older "23/36" survival-first form, or either in lower case.
+    [[nodiscard]] std::optional<Rule> parseRule(std::string_view notation);
+    [[nodiscard]] std::string notation(const Rule &rule);
+
+    // Instruction set variants the batch kernel is built for.
+    enum class Variant : uint8_t
+    {
+        Scalar = 0,
+        Avx2,
+        Avx512,
+    };
+
+    // Writes the next generation of every chunk in the batch to results, using the
+    // selected variant.
+    void evolve(const Batch &batch, Results &results, const Rule &rule);
+
+    [[nodiscard]] std::string_view name(Variant variant);
+    [[nodiscard]] std::optional<Variant> parse(std::string_view name);
+
+    // Whether the running CPU (and OS) can execute the given variant.
+    [[nodiscard]] bool supported(Variant variant);
+
+    // Widest variant the running CPU supports; this is selected at startup.
+    [[nodiscard]] Variant detect();
+
+    [[nodiscard]] Variant selected();
+    void select(Variant variant);
+
+    namespace detail
+    {
+        // Defined in separate translation units, each compiled for its own instruction set.
+        void evolveScalar(const Batch &batch, Results &results, const Rule &rule);
+        void evolveAvx2(const Batch &batch, Results &results, const Rule &rule);
+        void evolveAvx512(const Batch &batch, Results &results, const Rule &rule);
+    }
+
+    // The templates below are static on purpose. They are instantiated by translation
+    // units built with different -m flags, and a shared inline definition would let
+    // the linker hand the baseline build a copy that uses AVX instructions.
+    //
+    // The adder network is written against plain bitwise operators, so the same code
+    // runs on a single uint64_t or on a GCC vector of them.
+
+    template <typename Word>
+    [[nodiscard]] constexpr static std::tuple<Word, Word> halfAdder(Word a, Word b)
+    {
+        return {a ^ b, a & b};
+    }
+
+    template <typename Word>
+    [[nodiscard]] constexpr static std::tuple<Word, Word> fullAdder(Word a, Word b, Word c)
+    {
+        Word s = a ^ b;
+        return {s ^ c, (a & b) | (s & c)};
+    }
+
+    template <typename Word>
+    [[nodiscard]] constexpr static std::tuple<Word, Word, Word> adder2(Word a0, Word a1, Word b0, Word b1)
+    {
+        auto [s0, c0] = halfAdder(a0, b0);
+        auto [s1, c1] = fullAdder(a1, b1, c0);
+        return {s0, s1, c1};
+    }
+
+    template <typename Word>
+    [[nodiscard]] constexpr static std::tuple<Word, Word, Word, Word> adder3(Word a0, Word a1, Word a2, Word b0, Word b1, Word b2)
+    {
+        auto [s0, c0] = halfAdder(a0, b0);
+        auto [s1, c1] = fullAdder(a1, b1, c0);
+        auto [s2, c2] = fullAdder(a2, b2, c1);
+        return {s0, s1, s2, c2};
+    }
+
+    // Bit-sliced neighbour counts of every cell in chunk: bit i of each count is in
+    // the i-th word. Same layout and shifts as Chunk: bit (y * 8 + x) is the cell at (x, y).
+    template <typename Word>
+    [[nodiscard]] constexpr static std::tuple<Word, Word, Word, Word> count(Word chunk, Word north, Word south, Word west, Word east, Word northWest, Word northEast, Word southWest, Word southEast)
+    {
+        Word yn = north >> 56;
+        Word ys = south << 56;
+
+        Word x0 = ((chunk << 1) & 0xFEFEFEFEFEFEFEFEULL) | ((west >> 7) & 0x0101010101010101ULL); // left neighbor
+        Word x1 = ((chunk >> 1) & 0x7F7F7F7F7F7F7F7FULL) | ((east << 7) & 0x8080808080808080ULL); // right neighbor
+        Word x2 = (chunk << 8) | yn;                                                              // upper neighbor
+        Word x3 = (chunk >> 8) | ys;                                                              // lower neighbor
+        Word x4 = (x0 << 8) | ((yn << 1) & 0xFEULL) | (northWest >> 63);                          // upper left neighbor
+        Word x5 = (x0 >> 8) | ((ys << 1) & (0xFEULL << 56)) | (((southWest >> 7) & 1ULL) << 56);  // lower left neighbor
+        Word x6 = (x1 << 8) | ((yn >> 1) & 0x7FULL) | ((northEast >> 49) & 0x80ULL);              // upper right neighbor
+        Word x7 = (x1 >> 8) | ((ys >> 1) & (0x7FULL << 56)) | (southEast << 63);                  // lower right neighbor
+
+        auto [s01, c01] = halfAdder(x0, x1);
+        auto [s23, c23] = halfAdder(x2, x3);
+        auto [s45, c45] = halfAdder(x4, x5);
+        auto [s67, c67] = halfAdder(x6, x7);
+        auto [q00, q01, c0] = adder2(s01, c01, s23, c23);
+        auto [q10, q11, c1] = adder2(s45, c45, s67, c67);
+        return adder3(q00, q01, c0, q10, q11, c1);
+    }
+
+    // The function of the given words whose truth table is Table. Bit i of Table is
+    // its value where the first word has bit (n - 1) of i, the second bit (n - 2)
+    // and so on. It is built as a multiplexer tree over the words, and every branch
+    // that turns out constant is folded away, so the result is about as short as a
+    // hand-written expression.
+    template <uint32_t Table, typename Word, typename... Rest>
+    [[nodiscard]] constexpr static Word truth(Word first, Rest... rest)
+    {
+        constexpr unsigned int Half = 1U << sizeof...(Rest);
+        constexpr uint32_t Full = (uint32_t{1} << Half) - 1;
+        constexpr uint32_t Low = Table & Full;
+        constexpr uint32_t High = (Table >> Half) & Full;
+
+        if constexpr (Low == High && sizeof...(Rest) == 0)
+            return Low ? ~Word{} : Word{};
+        else if constexpr (Low == High)
+            return truth<Low>(rest...);
+        else if constexpr (Low == 0 && High == Full)
+            return first;
+        else if constexpr (Low == Full && High == 0)
+            return ~first;
+        else if constexpr (Low == 0)
+            return first & truth<High>(rest...);
+        else if constexpr (High == 0)
+            return ~first & truth<Low>(rest...);
+        else if constexpr (High == Full)
+            return first | truth<Low>(rest...);
+        else if constexpr (Low == Full)
+            return ~first | truth<High>(rest...);
+        else
+            return (first & truth<High>(rest...)) | (~first & truth<Low>(rest...));
+    }
+
+    // Next state of the cells under a rule known at compile time, from their
+    // current state and their bit-sliced neighbour counts. The table covers counts
+    // up to 7; a count of 8 has r0 to r2 clear and so reads the entry of 0, which
+    // r3 corrects where the two differ. For B3/S23 this comes down to the
+    // r1 & ~r2 & (r0 | cell) the kernel was first written with.
+    template <Rule R, typename Word>
+    [[nodiscard]] constexpr static Word next(Word cell, Word r0, Word r1, Word r2, Word r3)
+    {
+        constexpr uint32_t Table = []
+        {
+            uint32_t table = 0;
+
+            for (unsigned int n = 0; n < 8; n++)
+                table |= ((R.birth >> n) & 1U) << (2 * n) | ((R.survival >> n) & 1U) << (2 * n + 1);
+
+            return table;
+        }();
+
+        constexpr uint32_t Eight = ((R.birth >> 8) & 1U) | ((R.survival >> 8) & 1U) << 1;
+        Word result = truth<Table>(r2, r1, r0, cell);
+
+        if constexpr ((Eight ^ Table) & 3U)
+            result ^= r3 & truth<(Eight ^ Table) & 3U>(cell);
+
+        return result;
+    }
+
+    // Next state of the cells under any rule: a bit-sliced comparison of the counts
+    // against every count the rule mentions. The branches depend on the rule only,
+    // so they are the same for every cell.
+    template <typename Word>
+    [[nodiscard]] constexpr static Word next(const Rule &rule, Word cell, Word r0, Word r1, Word r2, Word r3)
+    {
+        Word result{};
+
+        for (unsigned int n = 0; n <= 8; n++)
+        {
+            bool born = (rule.birth >> n) & 1U;
+            bool survives = (rule.survival >> n) & 1U;
+
+            if (!born && !survives)
+                continue;
+
+            Word match = n == 8 ? r3 : ((n & 1U) ? r0 : ~r0) & ((n & 2U) ? r1 : ~r1) & ((n & 4U) ? r2 : ~r2);
+
+            if (n == 0)
+                match &= ~r3;
+
+            if (!born)
+                match &= cell;
+            else if (!survives)
+                match &= ~cell;
+
+            result |= match;
+        }
+
+        return result;
+    }
+
+    // Calls body with the logic of rule as a callable taking a cell and its counts:
+    // next<R> compiled for the rule if it is one of the Specialized ones, the
+    // generic comparison otherwise. Callers dispatch once per batch or tile.
+    template <size_t I = 0, typename Body>
+    static void withRule(const Rule &rule, Body &&body)
+    {
+        if constexpr (I < Specialized.size())
+        {
+            if (rule == Specialized[I])
+                body([](auto cell, auto r0, auto r1, auto r2, auto r3) { return next<Specialized[I]>(cell, r0, r1, r2, r3); });
+            else
+                withRule<I + 1>(rule, std::forward<Body>(body));
+        }
+        else
+        {
+            body([&rule](auto cell, auto r0, auto r1, auto r2, auto r3) { return next(rule, cell, r0, r1, r2, r3); });
+        }
+    }
+
+    template <typename Word, typename Next>
+    [[nodiscard]] constexpr static Word evolve(Next next, Word chunk, Word north, Word south, Word west, Word east, Word northWest, Word northEast, Word southWest, Word southEast)
+    {
+        auto [r0, r1, r2, r3] = count(chunk, north, south, west, east, northWest, northEast, southWest, southEast);
+        return next(chunk, r0, r1, r2, r3);
+    }
+
+    template <size_t Lanes>
+    struct Vector
+    {
+        // GCC drops a dependent vector_size from an alias declaration, but not from a typedef.
+        typedef uint64_t type __attribute__((vector_size(Lanes * sizeof(uint64_t)))); // NOLINT(modernize-use-using)
+    };
+
+    template <>
+    struct Vector<1>
+    {
+        using type = uint64_t;
+    };
+
+    // Runs the network over a batch, Lanes chunks at a time. Vector variants read
+    // whole vectors past batch.size, which stays inside the fixed-size arrays; the
+    // extra results are ignored by the caller.
+    template <size_t Lanes>
+    static void evolveBatch(const Batch &batch, Results &results, const Rule &rule)
+    {
+        using Word = typename Vector<Lanes>::type;
+        static_assert(sizeof(Word) == Lanes * sizeof(uint64_t) && Batch::Capacity % Lanes == 0);
+
+        auto load = [&](size_t position, size_t lane)
+        {
+            Word word; // NOLINT(cppcoreguidelines-init-variables)
+            std::memcpy(&word, &batch.words[position][lane], sizeof(Word)); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            return word;
+        };
+
+        withRule(rule, [&](auto next)
+        {
+            for (size_t lane = 0; lane < batch.size; lane += Lanes)
+            {
+                Word result = evolve(next, load(Batch::Center, lane),
+                                     load(Direction::North, lane), load(Direction::South, lane), load(Direction::West, lane), load(Direction::East, lane),
+                                     load(Direction::NorthWest, lane), load(Direction::NorthEast, lane), load(Direction::SouthWest, lane), load(Direction::SouthEast, lane));
+                std::memcpy(&results[lane], &result, sizeof(Word));
+            }
+        });
+    }
+}
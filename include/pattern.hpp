@@ -0,0 +1,35 @@
+#pragma once
+
+#include "BitBoard.hpp"
+
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace pattern
+{
+    enum class Format : uint8_t
+    {
+        Rle = 0,
+        Plaintext,
+        Macrocell,
+    };
+
+    [[nodiscard]] std::string_view name(Format format);
+
+    // Format named by the extension of path (.rle, .cells or .mc), if any.
+    [[nodiscard]] std::optional<Format> fromExtension(std::string_view path);
+
+    // Reads a pattern and ORs its live cells into board, a whole chunk at a time.
+    // RLE and plaintext patterns are placed with their top left cell at origin;
+    // macrocell trees are centred on it. Throws std::runtime_error on malformed
+    // input.
+    void read(std::istream &input, Format format, BitBoard &board, sf::Vector2i origin = {0, 0});
+
+    // Reads the pattern file at path, picking the format from its extension or,
+    // failing that, from its first character.
+    void load(const std::string &path, BitBoard &board, sf::Vector2i origin = {0, 0});
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "BitBoard.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Binary checkpoints of a board. A file is a Header followed by one Record per
+// live chunk, sorted by row and then by column, all in native byte order.
+namespace snapshot
+{
+    constexpr std::array<char, 8> Magic = {'C', 'O', 'N', 'W', 'A', 'Y', 'S', 'N'};
+    constexpr uint32_t Version = 1;
+
+    struct Header
+    {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t chunkSize;
+        uint64_t generation;
+        uint64_t count;
+    };
+
+    struct Record
+    {
+        int32_t x;
+        int32_t y;
+        uint64_t cells;
+    };
+
+    static_assert(sizeof(Header) == 32 && sizeof(Record) == 16, "snapshot layout must not have padding");
+
+    // Writes the live chunks of board to path with a single write. The file is
+    // written next to path and renamed over it afterwards, so an interrupted save
+    // leaves the previous snapshot intact. Returns the size of the file. Throws
+    // std::runtime_error on failure.
+    size_t save(const BitBoard &board, const std::string &path);
+
+    // Replaces board with the snapshot at path. The file is mapped instead of read
+    // and the board is built from it in one pass, see BitBoard::assign(). Throws
+    // std::runtime_error if the file cannot be read or is not a valid snapshot,
+    // leaving board untouched.
+    void load(const std::string &path, BitBoard &board);
+}
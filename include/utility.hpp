@@ -2,6 +2,7 @@
 
 #include <SFML/System/Vector2.hpp>
 #include <cassert>
+#include <cstdint>
 #include <functional>
 
 namespace utility
@@ -28,6 +29,25 @@ namespace utility
         return {floorDiv(v.x, u.x), floorDiv(v.y, u.y)};
     }
 
+    // Z-order of a position: the bits of both coordinates interleaved, so positions
+    // that are close on the plane are mostly close in the order too.
+    [[nodiscard]] constexpr uint64_t morton(sf::Vector2i v)
+    {
+        auto spread = [](int coordinate)
+        {
+            // Flipping the sign bit puts negative coordinates before positive ones.
+            uint64_t x = static_cast<uint32_t>(coordinate) ^ 0x80000000U;
+            x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+            x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+            x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+            x = (x | (x << 2)) & 0x3333333333333333ULL;
+            x = (x | (x << 1)) & 0x5555555555555555ULL;
+            return x;
+        };
+
+        return spread(v.x) | (spread(v.y) << 1);
+    }
+
     // https://dedu.fr/projects/bresenham/
     inline void gridTraversal(sf::Vector2f p1, sf::Vector2f p2, const std::function<void(sf::Vector2i)> &func)
     {
@@ -1,19 +1,138 @@
 #include "BitBoardRenderer.hpp"
+#include "BitBoard.hpp"
+#include "Chunk.hpp"
 #include "ChunkRenderer.hpp"
+#include "DensityPyramid.hpp"
 
+#include <SFML/Graphics/PrimitiveType.hpp>
+#include <SFML/Graphics/Rect.hpp>
 #include <SFML/Graphics/RenderStates.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/Transform.hpp>
-#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/VertexBuffer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
 
-void BitBoardRenderer::draw(sf::RenderTarget &target, sf::RenderStates states) const
+std::pair<BitBoard::ChunkPos, BitBoard::ChunkPos> BitBoardRenderer::chunksIn(sf::FloatRect area) const
 {
-    states.transform *= getTransform();
+    // Well past any chunk a board of int cell positions can hold.
+    static constexpr float Limit = 1 << 29;
+
+    sf::FloatRect local = getInverseTransform().transformRect(area);
 
-    for (const auto &[node, meta] : m_data)
+    auto chunk = [](float cell)
     {
-        ChunkRenderer chunk(node.chunk, m_color);
-        chunk.setPosition(static_cast<sf::Vector2f>(meta.pos * 8));
-        target.draw(chunk, states);
+        return static_cast<int>(std::clamp(std::floor(cell / 8.0F), -Limit, Limit));
+    };
+
+    return {{chunk(local.position.x), chunk(local.position.y)}, {chunk(local.position.x + local.size.x), chunk(local.position.y + local.size.y)}};
+}
+
+unsigned int BitBoardRenderer::level(float zoom)
+{
+    float pixels = static_cast<float>(Chunk::Size) / zoom;
+    unsigned int level = 0;
+
+    for (; level < DensityPyramid::Levels && pixels < MinimumPixels; level++)
+        pixels *= 2.0F;
+
+    return level;
+}
+
+void BitBoardRenderer::update(const std::shared_ptr<const BitBoard> &board, sf::FloatRect area)
+{
+    auto [min, max] = chunksIn(area);
+
+    if (board == m_board && m_level == 0 && min == m_min && max == m_max)
+        return;
+
+    m_board = board;
+    m_min = min;
+    m_max = max;
+    m_level = 0;
+    m_mesh.update(*board, m_color, min, max);
+    upload();
+}
+
+void BitBoardRenderer::update(const std::shared_ptr<const BitBoard> &board, const DensityPyramid &density, unsigned int level, sf::FloatRect area)
+{
+    auto [min, max] = chunksIn(area);
+
+    if (board == m_board && level == m_level && min == m_min && max == m_max)
+        return;
+
+    m_board = board;
+    m_min = min;
+    m_max = max;
+    m_level = level;
+    m_mesh.build(density, level, m_color, min, max);
+    upload();
+}
+
+void BitBoardRenderer::update(const BitBoard &board, sf::FloatRect area)
+{
+    auto [min, max] = chunksIn(area);
+
+    m_board = nullptr;
+    m_level = 0;
+    m_mesh.update(board, m_color, min, max);
+    upload();
+}
+
+void BitBoardRenderer::upload()
+{
+    if (!sf::VertexBuffer::isAvailable())
+        return;
+
+    const size_t count = m_mesh.size();
+
+    if (m_mesh.allDirty() || m_buffer.getVertexCount() < count)
+    {
+        // Room to grow, so that a board that grows a little at a time is not sent
+        // over in full every frame.
+        if (m_buffer.getVertexCount() < count && !m_buffer.create(2 * count))
+            throw std::runtime_error("Failed to create the vertex buffer.");
+
+        if (count > 0 && !m_buffer.update(m_mesh.data(), count, 0))
+            throw std::runtime_error("Failed to upload the vertex buffer.");
+
+        m_mesh.clean();
+        return;
+    }
+
+    m_uploads = m_mesh.dirty();
+    std::sort(m_uploads.begin(), m_uploads.end());
+
+    // Slots next to each other go over in one call.
+    for (size_t i = 0; i < m_uploads.size();)
+    {
+        const size_t first = m_uploads[i];
+        size_t end = first + BoardMesh::VerticesPerChunk;
+
+        for (i++; i < m_uploads.size() && m_uploads[i] <= end; i++)
+            end = std::max(end, m_uploads[i] + BoardMesh::VerticesPerChunk);
+
+        if (!m_buffer.update(m_mesh.data() + first, end - first, static_cast<unsigned int>(first))) // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            throw std::runtime_error("Failed to upload the vertex buffer.");
     }
+
+    m_mesh.clean();
+}
+
+void BitBoardRenderer::draw(sf::RenderTarget &target, sf::RenderStates states) const
+{
+    if (m_mesh.size() == 0)
+        return;
+
+    states.transform *= getTransform();
+    states.texture = m_level == 0 ? &ChunkRenderer::rowTexture() : nullptr;
+
+    if (sf::VertexBuffer::isAvailable())
+        target.draw(m_buffer, 0, m_mesh.size(), states);
+    else
+        target.draw(m_mesh.data(), m_mesh.size(), sf::PrimitiveType::Triangles, states);
 }
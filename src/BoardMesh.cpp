@@ -0,0 +1,218 @@
+#include "BoardMesh.hpp"
+#include "BitBoard.hpp"
+#include "Chunk.hpp"
+#include "DensityPyramid.hpp"
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+void BoardMesh::build(const BitBoard &board, sf::Color color)
+{
+    clear();
+
+    // Room for every row up front; rows that are empty are simply not written.
+    if (m_vertices.size() < board.size() * VerticesPerChunk)
+        m_vertices.resize(board.size() * VerticesPerChunk);
+
+    for (const auto &[chunk, pos] : board)
+        if (chunk)
+            append(chunk, static_cast<sf::Vector2f>(pos * 8), color);
+}
+
+void BoardMesh::build(const BitBoard &board, sf::Color color, BitBoard::ChunkPos min, BitBoard::ChunkPos max)
+{
+    clear();
+
+    board.query(min, max, [&](const Chunk &chunk, BitBoard::ChunkPos pos)
+    {
+        if (chunk)
+            append(chunk, static_cast<sf::Vector2f>(pos * 8), color);
+    });
+}
+
+void BoardMesh::update(const BitBoard &board, sf::Color color, BitBoard::ChunkPos min, BitBoard::ChunkPos max)
+{
+    if (!m_slotted || color != m_color)
+    {
+        reset();
+        m_color = color;
+    }
+
+    m_frame++;
+
+    board.query(min, max, [&](const Chunk &chunk, BitBoard::ChunkPos pos)
+    {
+        if (!chunk)
+            return;
+
+        auto [entry, added] = m_drawn.try_emplace(pos);
+        Drawn &drawn = entry->second;
+        drawn.frame = m_frame;
+
+        if (!added && drawn.chunk == chunk)
+            return;
+
+        if (added)
+        {
+            if (m_free.empty())
+            {
+                drawn.offset = m_count;
+                m_count += VerticesPerChunk;
+
+                if (m_vertices.size() < m_count)
+                    m_vertices.resize(std::max(m_count, 2 * m_vertices.size()));
+            }
+            else
+            {
+                drawn.offset = m_free.back();
+                m_free.pop_back();
+            }
+        }
+
+        drawn.chunk = chunk;
+        write(drawn.offset, chunk, static_cast<sf::Vector2f>(pos * 8), color);
+    });
+
+    boost::unordered::erase_if(m_drawn, [&](const auto &entry)
+    {
+        const Drawn &drawn = entry.second;
+
+        if (drawn.frame == m_frame)
+            return false;
+
+        write(drawn.offset, Chunk(), {}, color);
+        m_free.push_back(drawn.offset);
+        return true;
+    });
+
+    if (m_free.size() * 2 > m_count / VerticesPerChunk)
+    {
+        reset();
+        m_color = color;
+        update(board, color, min, max);
+    }
+}
+
+void BoardMesh::reset()
+{
+    clear();
+    m_slotted = true;
+    m_drawn.clear();
+    m_free.clear();
+    m_dirty.clear();
+}
+
+void BoardMesh::write(size_t offset, const Chunk &chunk, sf::Vector2f origin, sf::Color color)
+{
+    sf::Vertex *vertex = &m_vertices[offset];
+
+    for (unsigned int y = 0; y < 8; y++)
+    {
+        auto row = static_cast<uint8_t>(chunk.data() >> (8 * y));
+
+        if (!row)
+        {
+            for (size_t i = 0; i < VerticesPerRow; i++)
+                *vertex++ = {};
+
+            continue;
+        }
+
+        const float top = origin.y + static_cast<float>(y);
+        const float bottom = top + 1.0F;
+        const float left = origin.x;
+        const float right = left + 8.0F;
+        const auto texTop = static_cast<float>(row);
+        const float texBottom = texTop + 1.0F;
+
+        *vertex++ = {{left, top}, color, {0.0F, texTop}};
+        *vertex++ = {{right, top}, color, {8.0F, texTop}};
+        *vertex++ = {{left, bottom}, color, {0.0F, texBottom}};
+        *vertex++ = {{left, bottom}, color, {0.0F, texBottom}};
+        *vertex++ = {{right, top}, color, {8.0F, texTop}};
+        *vertex++ = {{right, bottom}, color, {8.0F, texBottom}};
+    }
+
+    if (!m_allDirty)
+        m_dirty.push_back(offset);
+}
+
+void BoardMesh::build(const DensityPyramid &density, unsigned int level, sf::Color color, BitBoard::ChunkPos min, BitBoard::ChunkPos max)
+{
+    clear();
+
+    const auto side = static_cast<float>(Chunk::Size << level);
+    const auto area = static_cast<float>(DensityPyramid::area(level));
+
+    density.query(level, min, max, [&](DensityPyramid::TilePos pos, uint32_t population)
+    {
+        // The square root keeps sparse tiles apart from empty ones without washing
+        // out the dense ones.
+        float shade = MinimumShade + ((1.0F - MinimumShade) * std::sqrt(static_cast<float>(population) / area));
+        appendTile(static_cast<sf::Vector2f>(pos) * side, side, shade, color);
+    });
+}
+
+void BoardMesh::append(const Chunk &chunk, sf::Vector2f origin, sf::Color color)
+{
+    if (m_vertices.size() < m_count + VerticesPerChunk)
+        m_vertices.resize(m_count + VerticesPerChunk);
+
+    auto put = [&](float x, float y, float u, float v)
+    {
+        m_vertices[m_count++] = {{x, y}, color, {u, v}};
+    };
+
+    for (unsigned int y = 0; y < 8; y++)
+    {
+        auto row = static_cast<uint8_t>(chunk.data() >> (8 * y));
+
+        if (!row)
+            continue;
+
+        const float top = origin.y + static_cast<float>(y);
+        const float bottom = top + 1.0F;
+        const float left = origin.x;
+        const float right = left + 8.0F;
+        const auto texTop = static_cast<float>(row);
+        const float texBottom = texTop + 1.0F;
+
+        put(left, top, 0.0F, texTop);
+        put(right, top, 8.0F, texTop);
+        put(left, bottom, 0.0F, texBottom);
+        put(left, bottom, 0.0F, texBottom);
+        put(right, top, 8.0F, texTop);
+        put(right, bottom, 8.0F, texBottom);
+    }
+}
+
+void BoardMesh::appendTile(sf::Vector2f origin, float side, float shade, sf::Color color)
+{
+    if (m_vertices.size() < m_count + VerticesPerRow)
+        m_vertices.resize(m_count + VerticesPerRow);
+
+    color.a = static_cast<uint8_t>(std::lround(static_cast<float>(color.a) * shade));
+
+    auto put = [&](float x, float y)
+    {
+        m_vertices[m_count++] = {{x, y}, color, {}};
+    };
+
+    const float left = origin.x;
+    const float top = origin.y;
+    const float right = left + side;
+    const float bottom = top + side;
+
+    put(left, top);
+    put(right, top);
+    put(left, bottom);
+    put(left, bottom);
+    put(right, top);
+    put(right, bottom);
+}
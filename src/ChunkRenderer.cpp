@@ -1,13 +1,12 @@
 #include "ChunkRenderer.hpp"
+#include "BoardMesh.hpp"
 #include "Logger.hpp"
 
-#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/PrimitiveType.hpp>
 #include <SFML/Graphics/RenderStates.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
-#include <SFML/Graphics/Sprite.hpp>
 #include <SFML/Graphics/Texture.hpp>
 #include <SFML/Graphics/Transform.hpp>
-#include <SFML/System/Vector2.hpp>
 #include <cstddef>
 #include <cstdint>
 #include <stdexcept>
@@ -55,14 +54,13 @@ void ChunkRenderer::initializeSprites(Logger &logger)
 
 void ChunkRenderer::draw(sf::RenderTarget &target, sf::RenderStates states) const
 {
-    states.transform *= getTransform();
+    BoardMesh mesh;
+    mesh.append(m_data, {0.0F, 0.0F}, m_color);
 
-    for (int i = 0; i < 8; i++)
-    {
-        sf::Sprite sprite(texture, sf::IntRect({0, static_cast<int>((m_data.data() >> (8 * i)) % 256)}, {8, 1}));
-        sprite.setColor(m_color);
-        target.draw(sprite, states);
+    if (mesh.size() == 0)
+        return;
 
-        states.transform = states.transform.translate({0, 1});
-    }
+    states.transform *= getTransform();
+    states.texture = &texture;
+    target.draw(mesh.data(), mesh.size(), sf::PrimitiveType::Triangles, states);
 }
@@ -0,0 +1,113 @@
+#include "DensityPyramid.hpp"
+#include "BitBoard.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace
+{
+    [[nodiscard]] int64_t population(const Chunk &chunk)
+    {
+        return std::popcount(chunk.data());
+    }
+
+    [[nodiscard]] DensityPyramid::TilePos parent(DensityPyramid::TilePos pos)
+    {
+        return {pos.x >> 1, pos.y >> 1};
+    }
+}
+
+void DensityPyramid::propagate()
+{
+    for (unsigned int level = 1; level <= Levels; level++)
+    {
+        auto &tiles = m_levels[level - 1];
+        m_nextChanges.clear();
+
+        for (const auto &[pos, change] : m_changes)
+        {
+            if (change == 0)
+                continue;
+
+            auto entry = tiles.try_emplace(pos, 0).first;
+            entry->second = static_cast<uint32_t>(entry->second + change);
+
+            if (entry->second == 0)
+                tiles.erase(entry);
+
+            if (level < Levels)
+                m_nextChanges[parent(pos)] += change;
+        }
+
+        std::swap(m_changes, m_nextChanges);
+    }
+
+    m_changes.clear();
+}
+
+void DensityPyramid::rebuild(const BitBoard &board)
+{
+    for (auto &tiles : m_levels)
+        tiles.clear();
+
+    m_counted.clear();
+    m_changes.clear();
+
+    for (const auto &[chunk, pos] : board)
+    {
+        if (chunk)
+        {
+            m_counted.emplace(pos, population(chunk));
+            m_changes[parent(pos)] += population(chunk);
+        }
+    }
+
+    propagate();
+    m_generation = board.getGeneration();
+}
+
+void DensityPyramid::update(const BitBoard &board)
+{
+    if (board.changesSince() == 0 || board.changesSince() > m_generation)
+    {
+        rebuild(board);
+        return;
+    }
+
+    m_changes.clear();
+
+    for (BitBoard::ChunkPos pos : board.changes())
+    {
+        auto found = board.find(pos);
+        int64_t now = found != board.end() ? population(found->chunk) : 0;
+        auto counted = m_counted.find(pos);
+        int64_t before = counted != m_counted.end() ? counted->second : 0;
+
+        if (now == before)
+            continue;
+
+        if (now == 0)
+            m_counted.erase(counted);
+        else if (counted != m_counted.end())
+            counted->second = static_cast<uint32_t>(now);
+        else
+            m_counted.emplace(pos, static_cast<uint32_t>(now));
+
+        m_changes[parent(pos)] += now - before;
+    }
+
+    propagate();
+    m_generation = board.getGeneration();
+}
+
+size_t DensityPyramid::bytes() const
+{
+    size_t bytes = m_counted.bucket_count() * (sizeof(std::pair<BitBoard::ChunkPos, uint32_t>) + 1);
+
+    for (const auto &tiles : m_levels)
+        bytes += tiles.bucket_count() * (sizeof(std::pair<TilePos, uint32_t>) + 1);
+
+    return bytes;
+}
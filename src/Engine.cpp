@@ -0,0 +1,43 @@
+#include "Engine.hpp"
+#include "BitBoard.hpp"
+#include "HashLife.hpp"
+#include "conway.hpp"
+#include "kernel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+void BitBoardEngine::advance(const BitBoard &previous, BitBoard &current, unsigned int exponent)
+{
+    m_counters += conway::tick(previous, current, m_workers, m_rule);
+
+    for (uint64_t i = 1; i < (1ULL << exponent); i++)
+    {
+        m_counters += conway::tick(current, m_scratch, m_workers, m_rule);
+        m_scratch.addChanges(current);
+        std::swap(current, m_scratch);
+    }
+}
+
+std::optional<EngineType> parseEngine(std::string_view name)
+{
+    if (name == "bitboard")
+        return EngineType::BitBoard;
+
+    if (name == "hashlife")
+        return EngineType::HashLife;
+
+    return std::nullopt;
+}
+
+std::unique_ptr<Engine> makeEngine(EngineType type, size_t threads, const kernel::Rule &rule)
+{
+    if (type == EngineType::HashLife)
+        return std::make_unique<HashLife>(rule);
+
+    return std::make_unique<BitBoardEngine>(threads, rule);
+}
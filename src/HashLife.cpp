@@ -0,0 +1,368 @@
+#include "HashLife.hpp"
+#include "BitBoard.hpp"
+#include "Chunk.hpp"
+#include "kernel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    using Entry = std::pair<BitBoard::ChunkPos, uint64_t>;
+
+    // Centre 8x8 cells of the 16x16 square made of four chunks.
+    [[nodiscard]] constexpr uint64_t centreOf(uint64_t northWest, uint64_t northEast, uint64_t southWest, uint64_t southEast)
+    {
+        return ((northWest >> 36) & 0x000000000F0F0F0FULL) |
+               ((northEast >> 28) & 0x00000000F0F0F0F0ULL) |
+               ((southWest << 28) & 0x0F0F0F0F00000000ULL) |
+               ((southEast << 36) & 0xF0F0F0F000000000ULL);
+    }
+}
+
+HashLife::NodeId HashLife::leaf(uint64_t data)
+{
+    auto [entry, inserted] = m_leaves.try_emplace(data, static_cast<NodeId>(m_nodes.size()));
+
+    if (inserted)
+    {
+        Node &node = m_nodes.emplace_back();
+        node.leaf = data;
+        node.population = static_cast<uint64_t>(std::popcount(data));
+    }
+
+    return entry->second;
+}
+
+HashLife::NodeId HashLife::join(NodeId northWest, NodeId northEast, NodeId southWest, NodeId southEast)
+{
+    std::array<NodeId, 4> children = {northWest, northEast, southWest, southEast};
+    auto [entry, inserted] = m_branches.try_emplace(children, static_cast<NodeId>(m_nodes.size()));
+
+    if (inserted)
+    {
+        Node node;
+        node.children = children;
+        node.level = static_cast<uint8_t>(m_nodes[northWest].level + 1);
+
+        for (auto child : children)
+            node.population += m_nodes[child].population;
+
+        m_nodes.push_back(node);
+    }
+
+    return entry->second;
+}
+
+HashLife::NodeId HashLife::empty(unsigned int level)
+{
+    while (m_empty.size() <= level)
+    {
+        if (m_empty.size() < 3)
+        {
+            m_empty.push_back(None);
+        }
+        else if (m_empty.size() == 3)
+        {
+            m_empty.push_back(leaf(0));
+        }
+        else
+        {
+            NodeId child = m_empty.back();
+            m_empty.push_back(join(child, child, child, child));
+        }
+    }
+
+    return m_empty[level];
+}
+
+HashLife::NodeId HashLife::centre(NodeId id)
+{
+    const Node node = m_nodes[id];
+    const Node nw = m_nodes[node.children[0]];
+    const Node ne = m_nodes[node.children[1]];
+    const Node sw = m_nodes[node.children[2]];
+    const Node se = m_nodes[node.children[3]];
+
+    if (node.level == 4)
+        return leaf(centreOf(nw.leaf, ne.leaf, sw.leaf, se.leaf));
+
+    return join(nw.children[3], ne.children[2], sw.children[1], se.children[0]);
+}
+
+HashLife::NodeId HashLife::expand(NodeId id)
+{
+    const Node node = m_nodes[id];
+    NodeId e = empty(node.level - 1U);
+
+    return join(join(e, e, e, node.children[0]),
+                join(e, e, node.children[1], e),
+                join(e, node.children[2], e, e),
+                join(node.children[3], e, e, e));
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+HashLife::NodeId HashLife::successor(NodeId id, unsigned int exponent)
+{
+    const Node node = m_nodes[id];
+    const unsigned int step = std::min(exponent, node.level - 2U);
+
+    if (node.population == 0)
+        return empty(node.level - 1U);
+
+    if (node.result != None && node.resultExponent == step)
+        return node.result;
+
+    NodeId result; // NOLINT(cppcoreguidelines-init-variables)
+
+    if (node.level == 4)
+    {
+        // Base case: run the chunk kernel on the 16x16 square with nothing around it.
+        // After t <= 4 generations the centre 8x8 cells are still exact.
+        uint64_t nw = m_nodes[node.children[0]].leaf;
+        uint64_t ne = m_nodes[node.children[1]].leaf;
+        uint64_t sw = m_nodes[node.children[2]].leaf;
+        uint64_t se = m_nodes[node.children[3]].leaf;
+
+        kernel::withRule(m_rule, [&](auto next)
+        {
+            for (unsigned int i = 0; i < (1U << step); i++)
+            {
+                uint64_t nextNw = kernel::evolve<uint64_t>(next, nw, 0, sw, 0, ne, 0, 0, 0, se);
+                uint64_t nextNe = kernel::evolve<uint64_t>(next, ne, 0, se, nw, 0, 0, 0, sw, 0);
+                uint64_t nextSw = kernel::evolve<uint64_t>(next, sw, nw, 0, 0, se, 0, ne, 0, 0);
+                uint64_t nextSe = kernel::evolve<uint64_t>(next, se, ne, 0, sw, 0, nw, 0, 0, 0);
+                nw = nextNw;
+                ne = nextNe;
+                sw = nextSw;
+                se = nextSe;
+            }
+        });
+
+        result = leaf(centreOf(nw, ne, sw, se));
+    }
+    else
+    {
+        const Node a = m_nodes[node.children[0]];
+        const Node b = m_nodes[node.children[1]];
+        const Node c = m_nodes[node.children[2]];
+        const Node d = m_nodes[node.children[3]];
+
+        // Nine overlapping subsquares of half the size, in reading order.
+        std::array<NodeId, 9> parts = {
+            node.children[0],
+            join(a.children[1], b.children[0], a.children[3], b.children[2]),
+            node.children[1],
+            join(a.children[2], a.children[3], c.children[0], c.children[1]),
+            join(a.children[3], b.children[2], c.children[1], d.children[0]),
+            join(b.children[2], b.children[3], d.children[0], d.children[1]),
+            node.children[2],
+            join(c.children[1], d.children[0], c.children[3], d.children[2]),
+            node.children[3],
+        };
+
+        // At full speed both halves of the step advance time; for shorter steps the
+        // first half only recentres.
+        for (auto &part : parts)
+            part = step == node.level - 2U ? successor(part, exponent) : centre(part);
+
+        result = join(successor(join(parts[0], parts[1], parts[3], parts[4]), exponent),
+                      successor(join(parts[1], parts[2], parts[4], parts[5]), exponent),
+                      successor(join(parts[3], parts[4], parts[6], parts[7]), exponent),
+                      successor(join(parts[4], parts[5], parts[7], parts[8]), exponent));
+    }
+
+    m_nodes[id].result = result;
+    m_nodes[id].resultExponent = static_cast<uint8_t>(step);
+    return result;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+HashLife::NodeId HashLife::build(unsigned int level, int64_t x, int64_t y, Entry *first, Entry *last)
+{
+    if (first == last)
+        return empty(level);
+
+    if (level == 3)
+        return leaf(first->second);
+
+    const int64_t half = int64_t{1} << (level - 4);
+
+    Entry *middle = std::partition(first, last, [&](const Entry &entry)
+    {
+        return entry.first.y < y + half;
+    });
+
+    Entry *northMiddle = std::partition(first, middle, [&](const Entry &entry)
+    {
+        return entry.first.x < x + half;
+    });
+
+    Entry *southMiddle = std::partition(middle, last, [&](const Entry &entry)
+    {
+        return entry.first.x < x + half;
+    });
+
+    NodeId nw = build(level - 1, x, y, first, northMiddle);
+    NodeId ne = build(level - 1, x + half, y, northMiddle, middle);
+    NodeId sw = build(level - 1, x, y + half, middle, southMiddle);
+    NodeId se = build(level - 1, x + half, y + half, southMiddle, last);
+    return join(nw, ne, sw, se);
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+void HashLife::collect(NodeId id, int64_t x, int64_t y, std::vector<Entry> &chunks) const
+{
+    const Node &node = m_nodes[id];
+
+    if (node.population == 0)
+        return;
+
+    if (node.level == 3)
+    {
+        // The cells of the chunk have to be addressable on a BitBoard as well.
+        constexpr int64_t Min = std::numeric_limits<int>::min() / static_cast<int64_t>(Chunk::Size);
+        constexpr int64_t Max = std::numeric_limits<int>::max() / static_cast<int64_t>(Chunk::Size);
+
+        if (x < Min || x > Max || y < Min || y > Max)
+            throw std::runtime_error("The pattern has grown past the edge of the board.");
+
+        chunks.emplace_back(BitBoard::ChunkPos(static_cast<int>(x), static_cast<int>(y)), node.leaf);
+        return;
+    }
+
+    const int64_t half = int64_t{1} << (node.level - 4);
+    collect(node.children[0], x, y, chunks);
+    collect(node.children[1], x + half, y, chunks);
+    collect(node.children[2], x, y + half, chunks);
+    collect(node.children[3], x + half, y + half, chunks);
+}
+
+void HashLife::reset()
+{
+    m_nodes.clear();
+    m_leaves.clear();
+    m_branches.clear();
+    m_empty.clear();
+    m_root = None;
+}
+
+void HashLife::load(std::vector<Entry> chunks)
+{
+    reset();
+
+    if (chunks.empty())
+    {
+        m_originX = 0;
+        m_originY = 0;
+        m_root = empty(5);
+        return;
+    }
+
+    int64_t minX = std::numeric_limits<int64_t>::max();
+    int64_t minY = std::numeric_limits<int64_t>::max();
+    int64_t maxX = std::numeric_limits<int64_t>::min();
+    int64_t maxY = std::numeric_limits<int64_t>::min();
+
+    for (const auto &[pos, data] : chunks)
+    {
+        minX = std::min<int64_t>(minX, pos.x);
+        minY = std::min<int64_t>(minY, pos.y);
+        maxX = std::max<int64_t>(maxX, pos.x);
+        maxY = std::max<int64_t>(maxY, pos.y);
+    }
+
+    const auto extent = static_cast<uint64_t>(std::max(maxX - minX, maxY - minY) + 1);
+    const auto level = std::max(4U, 3U + static_cast<unsigned int>(std::bit_width(extent - 1)));
+
+    m_originX = minX;
+    m_originY = minY;
+    m_root = build(level, minX, minY, chunks.data(), chunks.data() + chunks.size());
+}
+
+void HashLife::collectGarbage()
+{
+    std::vector<Entry> chunks;
+    collect(m_root, m_originX, m_originY, chunks);
+    load(std::move(chunks));
+}
+
+void HashLife::load(const BitBoard &board)
+{
+    std::vector<Entry> chunks;
+    chunks.reserve(board.size());
+
+    for (const auto &[chunk, pos] : board)
+        if (chunk)
+            chunks.emplace_back(pos, chunk.data());
+
+    load(std::move(chunks));
+    m_generation = 0;
+}
+
+void HashLife::store(BitBoard &board) const
+{
+    std::vector<Entry> chunks;
+    collect(m_root, m_originX, m_originY, chunks);
+
+    for (const auto &[pos, data] : chunks)
+        board.store(pos, Chunk(data));
+}
+
+void HashLife::step(unsigned int exponent)
+{
+    if (m_root == None)
+        m_root = empty(5);
+
+    if (m_nodes.size() > GarbageThreshold)
+        collectGarbage();
+
+    // The pattern has to sit in the centre quarter of the root, far enough from the
+    // edges that nothing it does in 2^exponent generations can reach them.
+    while (m_nodes[m_root].level < std::max(5U, exponent + 3) || m_nodes[centre(centre(m_root))].population != m_nodes[m_root].population)
+    {
+        const int64_t quarter = int64_t{1} << (m_nodes[m_root].level - 4);
+        m_root = expand(m_root);
+        m_originX -= quarter;
+        m_originY -= quarter;
+    }
+
+    const int64_t quarter = int64_t{1} << (m_nodes[m_root].level - 5);
+    m_root = successor(m_root, exponent);
+    m_originX += quarter;
+    m_originY += quarter;
+    m_generation += 1ULL << exponent;
+
+    // Drop empty borders again, so the next step does not start from an ever larger root.
+    while (m_nodes[m_root].level > 5 && m_nodes[centre(m_root)].population == m_nodes[m_root].population)
+    {
+        const int64_t quarter = int64_t{1} << (m_nodes[m_root].level - 5);
+        m_root = centre(m_root);
+        m_originX += quarter;
+        m_originY += quarter;
+    }
+}
+
+void HashLife::advance(const BitBoard &previous, BitBoard &current, unsigned int exponent)
+{
+    // The tree is kept between calls; it only has to be rebuilt when previous is not
+    // the object this engine wrote into last time, which is why Engine::advance()
+    // asks callers to pass the same two boards back and forth.
+    if (&previous != m_exported || previous.getGeneration() != m_exportedGeneration)
+        load(previous);
+
+    step(exponent);
+
+    current.setGeneration(previous.getGeneration() + (BitBoard::Generation{1} << exponent));
+    store(current);
+
+    m_exported = &current;
+    m_exportedGeneration = current.getGeneration();
+}
@@ -0,0 +1,158 @@
+#include "LifeWindow.hpp"
+#include "BitBoard.hpp"
+#include "BitBoardRenderer.hpp"
+#include "DensityPyramid.hpp"
+#include "Engine.hpp"
+#include "Logger.hpp"
+#include "Options.hpp"
+#include "Simulation.hpp"
+#include "Window.hpp"
+#include "snapshot.hpp"
+#include "utility.hpp"
+
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Window/Event.hpp>
+#include <SFML/Window/Keyboard.hpp>
+#include <SFML/Window/Mouse.hpp>
+#include <chrono>
+#include <memory>
+#include <utility>
+
+void LifeWindow::initialize()
+{
+    simulation->start();
+}
+
+void LifeWindow::deinitialize()
+{
+    simulation->stop();
+
+    if (Simulation::CheckpointStats stats = simulation->checkpointStats(); stats.written + stats.failed > 0)
+    {
+        double averageMilliseconds = stats.written > 0 ? stats.totalMilliseconds / static_cast<double>(stats.written) : 0.0;
+        logger.info("Wrote {} checkpoints ({} failed) of {} bytes in total, taking {} ms on average.", stats.written, stats.failed, stats.totalBytes, averageMilliseconds);
+    }
+
+    if (savePath)
+    {
+        logger.info("Saving the board to '{}'...", *savePath);
+        snapshot::save(*simulation->snapshot(), *savePath);
+    }
+}
+
+void LifeWindow::update()
+{
+    if (simulation->exception())
+        window.close();
+}
+
+// Anything else that is drawn only changes on events.
+bool LifeWindow::changed()
+{
+    return simulation->snapshot() != boardRenderer.board();
+}
+
+void LifeWindow::draw()
+{
+    std::shared_ptr<const BitBoard> board = simulation->snapshot();
+
+    unsigned int level = BitBoardRenderer::level(zoom());
+    simulation->trackDensity(level > 0);
+
+    if (level > 0)
+    {
+        simulation->readDensity([&](const DensityPyramid &density)
+        {
+            boardRenderer.update(board, density, level, visibleArea());
+        });
+    }
+    else
+    {
+        boardRenderer.update(board, visibleArea());
+    }
+
+    bufferRenderer.update(drawBuffer, visibleArea());
+
+    window.draw(boardRenderer);
+    window.draw(bufferRenderer);
+}
+
+LifeWindow::LifeWindow(Logger &logger, unsigned int width, unsigned int height, std::unique_ptr<Engine> engine, BitBoard board, const Options &options) : Window(logger, width, height, "Conway's Game of Life", BackgroundColor), simulation(std::make_shared<Simulation>(logger, std::move(engine), std::move(board), options.step)), savePath(options.save), jump(options.jump)
+{
+    simulation->setTargetRate(options.rate);
+
+    if (options.checkpoint)
+        simulation->enableCheckpoints(*options.checkpoint, options.checkpointGenerations, std::chrono::seconds(options.checkpointSeconds));
+
+    addEventHandler<sf::Event::KeyPressed>([&](const sf::Event::KeyPressed &event)
+    {
+        if (event.scancode == sf::Keyboard::Scan::Space)
+        {
+            bool paused = simulation->togglePause();
+            background = paused ? PausedColor : BackgroundColor;
+        }
+
+        if (event.scancode == sf::Keyboard::Scan::Right)
+        {
+            if (event.shift)
+                simulation->scheduleAdvance(jump);
+            else
+                simulation->scheduleStep();
+        }
+
+        if (event.scancode == sf::Keyboard::Scan::Delete)
+            simulation->scheduleClear();
+
+        if (event.scancode == sf::Keyboard::Scan::S && this->savePath)
+            simulation->scheduleSave(*this->savePath);
+    });
+
+    addEventHandler<sf::Event::MouseButtonPressed>([&](const sf::Event::MouseButtonPressed &event)
+    {
+        if (event.button == sf::Mouse::Button::Left)
+            drawBuffer.set(utility::floor(worldPos), true);
+
+        if (event.button == sf::Mouse::Button::Right)
+            simulation->scheduleModify([worldPos = worldPos](BitBoard &lifeBoard)
+            {
+                lifeBoard.set(utility::floor(worldPos), false);
+            });
+    });
+
+    addEventHandler<sf::Event::MouseMoved>([&](const sf::Event::MouseMoved &)
+    {
+        if (sf::Mouse::isButtonPressed(sf::Mouse::Button::Left))
+            utility::gridTraversal(worldPos, prevWorldPos, [&](sf::Vector2i pos)
+            {
+                drawBuffer.set(pos, true);
+            });
+
+        if (sf::Mouse::isButtonPressed(sf::Mouse::Button::Right))
+        {
+            BitBoard eraseBuffer;
+            utility::gridTraversal(worldPos, prevWorldPos, [&](sf::Vector2i pos)
+            {
+                eraseBuffer.set(pos, true);
+            });
+
+            simulation->scheduleModify([eraseBuffer = std::move(eraseBuffer)](BitBoard &lifeBoard)
+            {
+                lifeBoard -= eraseBuffer;
+            });
+        }
+    });
+
+    addEventHandler<sf::Event::MouseButtonReleased>([&](const sf::Event::MouseButtonReleased &event)
+    {
+        if (event.button == sf::Mouse::Button::Left)
+        {
+            simulation->scheduleModify([drawBuffer = std::move(drawBuffer)](BitBoard &lifeBoard)
+            {
+                lifeBoard |= drawBuffer;
+            });
+
+            drawBuffer = BitBoard();
+        }
+    });
+}
@@ -1,12 +1,45 @@
 #include "Options.hpp"
+#include "Engine.hpp"
 #include "Logger.hpp"
+#include "benchmark.hpp"
+#include "kernel.hpp"
 
 #include <SFML/Config.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
 #include <iostream>
+#include <string>
 #include <syncstream>
+#include <system_error>
+#include <thread>
+
+namespace
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays, cppcoreguidelines-pro-bounds-pointer-arithmetic, modernize-avoid-c-arrays)
+    std::string takeValue(int argc, char *argv[], int &i, const std::string &option, const std::string &executable)
+    {
+        if (i + 1 >= argc)
+            throw Options::Error("Option '" + option + "' requires a value.", executable);
+
+        return argv[++i]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+
+    template <typename T = unsigned int>
+    T parseUnsigned(const std::string &value, const std::string &option, const std::string &executable)
+    {
+        T result = 0;
+        auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+
+        if (error != std::errc() || end != value.data() + value.size())
+            throw Options::Error("Invalid value '" + value + "' for option '" + option + "'.", executable);
+
+        return result;
+    }
+}
 
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays, cppcoreguidelines-pro-bounds-pointer-arithmetic, modernize-avoid-c-arrays)
-Options::Options(int argc, char *argv[]) : m_executable(argv[0])
+Options::Options(int argc, char *argv[]) : m_executable(argv[0]), threads(std::max(1U, std::thread::hardware_concurrency()))
 {
     bool readingOptions = true;
 
@@ -54,23 +87,229 @@ Options::Options(int argc, char *argv[]) : m_executable(argv[0])
                 continue;
             }
 
+            if (arg == "--compare-tiles")
+            {
+                compareTiles = true;
+                continue;
+            }
+
+            if (arg == "--json")
+            {
+                json = true;
+                continue;
+            }
+
+            if (arg == "--workload")
+            {
+                std::string value = takeValue(argc, argv, i, arg, m_executable);
+
+                if (!benchmark::find(value))
+                {
+                    std::string names;
+
+                    for (const auto &workload : benchmark::workloads())
+                        names += (names.empty() ? "'" : ", '") + workload.name + "'";
+
+                    throw Error("Unknown workload '" + value + "', expected one of " + names + ".", m_executable);
+                }
+
+                workloads.push_back(value);
+                continue;
+            }
+
+            if (arg == "--generations")
+            {
+                generations = parseUnsigned(takeValue(argc, argv, i, arg, m_executable), arg, m_executable);
+                continue;
+            }
+
+            if (arg == "--warmup")
+            {
+                warmup = parseUnsigned(takeValue(argc, argv, i, arg, m_executable), arg, m_executable);
+                continue;
+            }
+
+            if (arg == "--trials")
+            {
+                trials = parseUnsigned(takeValue(argc, argv, i, arg, m_executable), arg, m_executable);
+
+                if (trials == 0)
+                    throw Error("Option '" + arg + "' requires at least one trial.", m_executable);
+
+                continue;
+            }
+
+            if (arg == "--threads")
+            {
+                threads = parseUnsigned(takeValue(argc, argv, i, arg, m_executable), arg, m_executable);
+
+                if (threads == 0)
+                    throw Error("Option '" + arg + "' requires at least one thread.", m_executable);
+
+                continue;
+            }
+
+            if (arg == "--kernel")
+            {
+                std::string value = takeValue(argc, argv, i, arg, m_executable);
+                kernel = kernel::parse(value);
+
+                if (!kernel)
+                    throw Error("Unknown kernel '" + value + "', expected 'scalar', 'avx2' or 'avx512'.", m_executable);
+
+                continue;
+            }
+
+            if (arg == "--engine")
+            {
+                std::string value = takeValue(argc, argv, i, arg, m_executable);
+                auto type = parseEngine(value);
+
+                if (!type)
+                    throw Error("Unknown engine '" + value + "', expected 'bitboard' or 'hashlife'.", m_executable);
+
+                engine = *type;
+                continue;
+            }
+
+            if (arg == "--rule")
+            {
+                std::string value = takeValue(argc, argv, i, arg, m_executable);
+                auto parsed = kernel::parseRule(value);
+
+                if (!parsed)
+                    throw Error("Invalid rule '" + value + "', expected B/S notation such as 'B36/S23'.", m_executable);
+
+                // A dead cell with no neighbours would come alive everywhere at once.
+                if (parsed->birth & 1U)
+                    throw Error("Rules with B0 are not supported, they fill the infinite board.", m_executable);
+
+                rule = *parsed;
+                continue;
+            }
+
+            if (arg == "--load")
+            {
+                patterns.push_back(takeValue(argc, argv, i, arg, m_executable));
+                continue;
+            }
+
+            if (arg == "--load-snapshot")
+            {
+                snapshot = takeValue(argc, argv, i, arg, m_executable);
+                continue;
+            }
+
+            if (arg == "--save")
+            {
+                save = takeValue(argc, argv, i, arg, m_executable);
+                continue;
+            }
+
+            if (arg == "--run")
+            {
+                run = parseUnsigned<uint64_t>(takeValue(argc, argv, i, arg, m_executable), arg, m_executable);
+                continue;
+            }
+
+            if (arg == "--checkpoint")
+            {
+                checkpoint = takeValue(argc, argv, i, arg, m_executable);
+                continue;
+            }
+
+            if (arg == "--checkpoint-every")
+            {
+                checkpointGenerations = parseUnsigned(takeValue(argc, argv, i, arg, m_executable), arg, m_executable);
+                continue;
+            }
+
+            if (arg == "--checkpoint-interval")
+            {
+                checkpointSeconds = parseUnsigned(takeValue(argc, argv, i, arg, m_executable), arg, m_executable);
+                continue;
+            }
+
+            if (arg == "--rate")
+            {
+                rate = parseUnsigned(takeValue(argc, argv, i, arg, m_executable), arg, m_executable);
+                continue;
+            }
+
+            if (arg == "--jump")
+            {
+                jump = parseUnsigned<uint64_t>(takeValue(argc, argv, i, arg, m_executable), arg, m_executable);
+                continue;
+            }
+
+            if (arg == "--step")
+            {
+                step = parseUnsigned(takeValue(argc, argv, i, arg, m_executable), arg, m_executable);
+
+                if (step > 48)
+                    throw Error("Option '" + arg + "' accepts at most 48.", m_executable);
+
+                continue;
+            }
+
             throw Error("Unknown option '" + arg + "'.", m_executable);
         }
+
+        patterns.push_back(arg);
     }
+
+    // The bitboard engine computes every generation of a tick, and hashlife writes
+    // the whole board out after every tick, so each only suits one end of --step.
+    if (engine == EngineType::BitBoard && step > BitBoardEngine::MaxStep)
+        throw Error("Option '--step' accepts at most " + std::to_string(BitBoardEngine::MaxStep) + " with the bitboard engine, use '--engine hashlife' for more.", m_executable);
+
+    if (engine == EngineType::HashLife && step == 0)
+        throw Error("The hashlife engine needs '--step' of 1 or more.", m_executable);
 }
 
 void Options::printHelp()
 {
     std::osyncstream stream(std::cerr);
-    stream << "Usage: " << m_executable << " [OPTIONS]\n";
+    stream << "Usage: " << m_executable << " [OPTIONS] [PATTERN...]\n";
     stream << "\n";
     stream << "Conway's Game of Life.\n";
+    stream << "Patterns in RLE, plaintext (.cells) or macrocell (.mc) format are loaded on top of each other.\n";
     stream << "\n";
     stream << "Options:\n";
     stream << "  -h, --help       Show this help message and exit\n";
     stream << "  -v, --version    Show version and exit\n";
     stream << "  --info           Show more logging information\n";
     stream << "  --debug          Show debugging information\n";
+    stream << "  --benchmark      Run the benchmark suite on the loaded patterns or the\n";
+    stream << "                   built-in workloads and exit\n";
+    stream << "  --workload NAME  Benchmark a built-in workload, may be repeated (default: all)\n";
+    stream << "  --generations N  Advances per benchmark trial (default: 1000)\n";
+    stream << "  --warmup N       Untimed trials before the timed ones (default: 1)\n";
+    stream << "  --trials N       Timed trials per workload (default: 5)\n";
+    stream << "  --compare-tiles  Time the tick with every tile size on built-in boards and exit\n";
+    stream << "  --json           Print benchmark or run results as JSON\n";
+    stream << "  --run N          Advance N generations without a window, print the\n";
+    stream << "                   population and exit\n";
+    stream << "  --threads N      Number of threads used for ticking (default: all cores)\n";
+    stream << "  --kernel NAME    Force the scalar, avx2 or avx512 tick kernel (default: best supported)\n";
+    stream << "  --engine NAME    Simulate with the bitboard or hashlife engine (default: bitboard)\n";
+    stream << "  --rule RULE      Simulate a Life-like rule in B/S notation (default: B3/S23)\n";
+    stream << "  --step K         Advance 2^K generations per tick (default: 0), at most 16\n";
+    stream << "                   with the bitboard engine and at least 1 with hashlife,\n";
+    stream << "                   which pays off from around 8\n";
+    stream << "  --rate N         Run at most N generations per second (default: 0, no limit)\n";
+    stream << "  --jump N         Generations to jump ahead by with Shift+Right (default: 1000)\n";
+    stream << "  --load FILE      Load a pattern file, like a PATTERN argument\n";
+    stream << "  --load-snapshot FILE\n";
+    stream << "                   Start from a snapshot file, with any patterns on top\n";
+    stream << "  --save FILE      Save a snapshot when the window closes or S is pressed,\n";
+    stream << "                   or after the benchmark or run\n";
+    stream << "  --checkpoint FILE\n";
+    stream << "                   Write a snapshot periodically while running\n";
+    stream << "  --checkpoint-every N\n";
+    stream << "                   Checkpoint every N generations (default: 0, off)\n";
+    stream << "  --checkpoint-interval S\n";
+    stream << "                   Checkpoint every S seconds (default: 600, 0 is off)\n";
     stream << "  --               Stop parsing options (treat following arguments as filename)\n";
 }
 
@@ -78,6 +317,7 @@ void Options::printVersion()
 {
     std::osyncstream stream(std::cout);
     stream << "conway " << CONWAY_VERSION_STRING << "\n";
+    stream << "kernel " << kernel::name(kernel::selected()) << " (detected " << kernel::name(kernel::detect()) << ")\n";
     stream << "sfml " << SFML_VERSION_MAJOR << "." << SFML_VERSION_MINOR << "." << SFML_VERSION_PATCH << "\n";
 }
 
@@ -1,19 +1,39 @@
 #include "Simulation.hpp"
 #include "BitBoard.hpp"
-#include "conway.hpp"
+#include "snapshot.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <ratio>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
+
+namespace
+{
+    [[nodiscard]] uint64_t nanosecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+}
 
 std::shared_ptr<BitBoard> Simulation::acquire()
 {
     std::unique_ptr<BitBoard> object;
+    size_t epoch = 0;
 
     {
         std::scoped_lock lock(m_poolMutex);
+        epoch = m_epoch;
 
         if (!m_pool.empty())
         {
@@ -30,14 +50,16 @@ std::shared_ptr<BitBoard> Simulation::acquire()
 
     std::weak_ptr<Simulation> weakSimulation = shared_from_this();
 
-    return {object.release(), [weakSimulation](BitBoard *ptr)
+    return {object.release(), [weakSimulation, epoch](BitBoard *ptr)
     {
         std::unique_ptr<BitBoard> object(ptr);
 
         if (auto simulation = weakSimulation.lock())
         {
             std::scoped_lock lock(simulation->m_poolMutex);
-            simulation->m_pool.push_back(std::move(object));
+
+            if (simulation->m_epoch == epoch)
+                simulation->m_pool.push_back(std::move(object));
         }
     }};
 }
@@ -45,8 +67,447 @@ std::shared_ptr<BitBoard> Simulation::acquire()
 void Simulation::clear()
 {
     logger.info("Clearing the object pool.");
+    m_ahead.reset();
+    m_next.reset();
+
     std::scoped_lock lock(m_poolMutex);
     m_pool.clear();
+    m_epoch++;
+}
+
+// Ticks m_ahead, or the published board if there is none, into m_ahead. Returns
+// whether edits went along.
+bool Simulation::advance(unsigned int exponent)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::shared_ptr<const BitBoard> previous = m_ahead ? m_ahead : m_data.load();
+    std::shared_ptr<BitBoard> buffer = m_next ? std::move(m_next) : acquire();
+
+    {
+        std::scoped_lock lock(m_tickingMutex);
+        m_ticking = true;
+        m_tickStarted = start;
+        m_tickingCondition.notify_all();
+    }
+
+    m_engine->advance(*previous, *buffer, exponent);
+
+    {
+        std::scoped_lock lock(m_tickingMutex);
+        m_ticking = false;
+    }
+
+    // Once a pass of the edit thread is over, the edit state is this thread's again.
+    std::vector<Edit> laneEdits;
+
+    {
+        std::scoped_lock lock(m_laneMutex);
+        laneEdits = std::exchange(m_laneEdits, {});
+    }
+
+    m_sinceCheckpoint += uint64_t{1} << exponent;
+
+    // The density pyramid is only brought to published boards, so the changes of
+    // the ones in between are carried along for it.
+    if (previous == m_ahead && m_densityTracked)
+        buffer->addChanges(*previous);
+
+    // A board that was never published is nobody else's, so the next tick can
+    // write into it.
+    m_next = std::move(m_ahead);
+    m_ahead = buffer;
+
+    m_lastAdvance = std::chrono::steady_clock::now() - start;
+
+    // Edits that came in during the tick do not have to wait for the next one.
+    {
+        std::scoped_lock lock(m_tickingMutex);
+
+        while (!m_taskQueue.empty() && m_taskQueue.front().edit)
+        {
+            defer(m_taskQueue.front().edit, m_taskQueue.front().scheduled);
+            m_taskQueue.pop();
+        }
+    }
+
+    const bool edited = !laneEdits.empty() || !m_deferred.empty();
+
+    // Edits the edit thread published are on screen already, so they are only
+    // replayed, ahead of the ones that came after.
+    for (const auto &edit : laneEdits)
+        edit(*buffer);
+
+    if (!m_deferred.empty())
+        mergeEdits(*buffer);
+    else if (edited)
+        m_engine->invalidate();
+
+    forgetEdits(buffer);
+    uint64_t nanoseconds = nanosecondsSince(start);
+
+    std::scoped_lock lock(m_statsMutex);
+    m_stats.advances++;
+    m_stats.generations += uint64_t{1} << exponent;
+    m_stats.advanceNanoseconds += nanoseconds;
+    m_stats.engine = m_engine->counters();
+    return edited;
+}
+
+void Simulation::publishAhead()
+{
+    if (m_ahead)
+        publish(std::exchange(m_ahead, nullptr));
+}
+
+std::shared_ptr<BitBoard> Simulation::applyEdits(const std::vector<Edit> &edits)
+{
+    std::shared_ptr<BitBoard> board;
+    const size_t logged = m_editBase + m_editLog.size();
+
+    auto spare = std::find_if(m_spares.begin(), m_spares.end(), std::mem_fn(&Spare::free));
+
+    const bool copied = spare == m_spares.end();
+
+    if (copied)
+    {
+        board = acquire();
+        *board = *m_data.load();
+    }
+    else
+    {
+        board = std::move(spare->board);
+
+        for (size_t i = spare->edits; i < logged; i++)
+            m_editLog[i - m_editBase](*board);
+
+        m_spares.erase(spare);
+    }
+
+    if (m_latest)
+        m_spares.push_back({std::move(m_latest), logged});
+
+    if (m_spares.size() > Spares)
+        m_spares.erase(m_spares.begin());
+
+    for (const auto &edit : edits)
+    {
+        edit(*board);
+        m_editLog.push_back(edit);
+    }
+
+    m_latest = board;
+    m_spareWanted = true;
+
+    // Edits every spare has seen are not needed any more.
+    size_t oldest = m_editBase + m_editLog.size();
+
+    for (const auto &remaining : m_spares)
+        oldest = std::min(oldest, remaining.edits);
+
+    m_editLog.erase(m_editLog.begin(), m_editLog.begin() + static_cast<std::ptrdiff_t>(oldest - m_editBase));
+    m_editBase = oldest;
+
+    std::scoped_lock lock(m_statsMutex);
+    m_stats.edits++;
+    m_stats.copies += static_cast<size_t>(copied);
+    return board;
+}
+
+// For a board only the ticking thread holds, which takes the edits as they are.
+void Simulation::mergeEdits(BitBoard &board)
+{
+    for (const auto &edit : m_deferred)
+        edit(board);
+
+    m_deferred.clear();
+    m_spareWanted = true;
+    m_engine->invalidate();
+    recordEditLatency();
+
+    std::scoped_lock lock(m_statsMutex);
+    m_stats.edits++;
+}
+
+void Simulation::defer(const Edit &edit, std::chrono::steady_clock::time_point scheduled)
+{
+    if (m_deferred.empty())
+        m_deferredSince = scheduled;
+
+    m_deferred.push_back(edit);
+}
+
+void Simulation::publishEdits()
+{
+    if (m_deferred.empty())
+        return;
+
+    if (m_ahead)
+    {
+        mergeEdits(*m_ahead);
+        publishAhead();
+        return;
+    }
+
+    std::vector<Edit> edits = std::move(m_deferred);
+    m_deferred.clear();
+    publish(applyEdits(edits));
+    m_engine->invalidate();
+    recordEditLatency();
+}
+
+// On the edit thread, with m_laneMutex held, while the engine is busy with a
+// tick. The engine is told about the edits by the tick that replays them.
+void Simulation::publishLaneEdits()
+{
+    // The spares lead up to m_latest, which may be a board ahead of the published
+    // one that is being ticked right now.
+    if (m_latest != m_data.load())
+        forgetEdits(nullptr);
+
+    std::vector<Edit> edits = std::move(m_deferred);
+    m_deferred.clear();
+    publish(applyEdits(edits));
+    recordEditLatency();
+    m_laneEdits.insert(m_laneEdits.end(), edits.begin(), edits.end());
+}
+
+void Simulation::recordEditLatency()
+{
+    uint64_t nanoseconds = nanosecondsSince(m_deferredSince);
+
+    std::scoped_lock lock(m_statsMutex);
+    m_stats.editLatencyNanoseconds += nanoseconds;
+    m_stats.maxEditLatencyNanoseconds = std::max(m_stats.maxEditLatencyNanoseconds, nanoseconds);
+}
+
+// For a board that did not come from applyEdits(), which leaves the spares behind.
+void Simulation::forgetEdits(std::shared_ptr<BitBoard> latest)
+{
+    m_latest = std::move(latest);
+    m_spares.clear();
+    m_editLog.clear();
+    m_editBase = 0;
+}
+
+bool Simulation::spareFree() const
+{
+    return std::any_of(m_spares.begin(), m_spares.end(), std::mem_fn(&Spare::free));
+}
+
+// Copies the published board into a spare that has every logged edit.
+void Simulation::prepareSpare()
+{
+    std::shared_ptr<BitBoard> board = acquire();
+    *board = *m_data.load();
+    m_spares.push_back({std::move(board), m_editBase + m_editLog.size()});
+
+    if (m_spares.size() > Spares)
+        m_spares.erase(m_spares.begin());
+
+    m_spareWanted = false;
+
+    std::scoped_lock lock(m_statsMutex);
+    m_stats.spares++;
+}
+
+// Storing the board also lets go of the one before, which may hand it back to
+// the pool, so both are timed together.
+void Simulation::publish(const std::shared_ptr<const BitBoard> &board)
+{
+    bool changed = board != m_data.load();
+
+    auto start = std::chrono::steady_clock::now();
+    m_data.store(board);
+    uint64_t nanoseconds = nanosecondsSince(start);
+
+    if (changed)
+        updateDensity(*board);
+
+    {
+        std::scoped_lock lock(m_statsMutex);
+        m_stats.published += static_cast<size_t>(changed);
+        m_stats.publishNanoseconds += nanoseconds;
+    }
+
+    offerCheckpoint(board);
+}
+
+void Simulation::updateDensity(const BitBoard &board)
+{
+    std::scoped_lock lock(m_densityMutex);
+    m_published++;
+
+    if (!m_densityTracked)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Only the board published right before this one is known to be the one that
+    // board's list of changes starts from.
+    if (m_densityVersion + 1 == m_published)
+        m_density.update(board);
+    else
+        m_density.rebuild(board);
+
+    m_densityVersion = m_published;
+    uint64_t nanoseconds = nanosecondsSince(start);
+
+    std::scoped_lock statsLock(m_statsMutex);
+    m_stats.densityNanoseconds += nanoseconds;
+}
+
+// Called with m_densityMutex held. A board published after the count is taken
+// here comes through updateDensity() again.
+void Simulation::catchUpDensity()
+{
+    if (m_densityVersion == m_published)
+        return;
+
+    m_density.rebuild(*m_data.load());
+    m_densityVersion = m_published;
+}
+
+void Simulation::report()
+{
+    auto now = std::chrono::steady_clock::now();
+
+    if (now - m_lastReport < ReportInterval)
+        return;
+
+    Stats stats = this->stats();
+    std::chrono::duration<double> elapsed = now - m_lastReport;
+    m_lastReport = now;
+
+    size_t advances = stats.advances - m_reported.advances;
+    uint64_t generations = stats.generations - m_reported.generations;
+    size_t published = stats.published - m_reported.published;
+    conway::Counters engine = stats.engine - m_reported.engine;
+    uint64_t advanceNanoseconds = stats.advanceNanoseconds - m_reported.advanceNanoseconds;
+    uint64_t publishNanoseconds = stats.publishNanoseconds - m_reported.publishNanoseconds;
+    uint64_t densityNanoseconds = stats.densityNanoseconds - m_reported.densityNanoseconds;
+    size_t tasks = stats.tasks - m_reported.tasks;
+    size_t edits = stats.edits - m_reported.edits;
+    size_t copies = stats.copies - m_reported.copies;
+    size_t spares = stats.spares - m_reported.spares;
+    uint64_t editLatencyNanoseconds = stats.editLatencyNanoseconds - m_reported.editLatencyNanoseconds;
+    m_reported = stats;
+
+    if (advances == 0)
+        return;
+
+    auto perAdvance = [&](auto value)
+    {
+        return static_cast<double>(value) / static_cast<double>(advances);
+    };
+
+    // Shares of the tick phases, in the order they run.
+    auto share = [&](uint64_t phase)
+    {
+        return engine.nanoseconds.total() > 0 ? 100.0 * static_cast<double>(phase) / static_cast<double>(engine.nanoseconds.total()) : 0.0;
+    };
+
+    logger.info("{} advances of {} generations in {} s, {} boards published ({} tasks, {} edits of which {} copied the board, {} spares made ahead): {} ms to advance, {} us to count densities and {} us to publish on average.", advances, generations, elapsed.count(), published, tasks, edits, copies, spares, perAdvance(advanceNanoseconds) / 1e6, perAdvance(densityNanoseconds) / 1e3, perAdvance(publishNanoseconds) / 1e3);
+    logger.info("Per advance: {} live chunks, {} birth candidates, {} computed, {} skipped, {} births, {} deaths, {} allocations, {} map lookups.", perAdvance(engine.live), perAdvance(engine.candidates), perAdvance(engine.computed), perAdvance(engine.skipped), perAdvance(engine.births), perAdvance(engine.deaths), perAdvance(engine.allocated), perAdvance(engine.lookups));
+    logger.info("Tick phases: {}% live, {}% candidates, {}% write back, {}% insert, {}% frontier, {}% relayout.", share(engine.nanoseconds.live), share(engine.nanoseconds.candidates), share(engine.nanoseconds.writeBack), share(engine.nanoseconds.insert), share(engine.nanoseconds.frontier), share(engine.nanoseconds.relayout));
+
+    if (edits > 0)
+        logger.info("Edits took {} ms on average from input to publishing, and {} ms at most so far.", static_cast<double>(editLatencyNanoseconds) / static_cast<double>(edits) / 1e6, static_cast<double>(stats.maxEditLatencyNanoseconds) / 1e6);
+}
+
+// Whether a checkpoint is due and the checkpoint thread is free to write it. One
+// that is due while it is busy is still due on the next tick, so nothing is lost
+// by not waiting for it.
+bool Simulation::checkpointDue(std::chrono::steady_clock::time_point now)
+{
+    if (m_checkpointPath.empty())
+        return false;
+
+    bool generationsDue = m_checkpointGenerations > 0 && m_sinceCheckpoint >= m_checkpointGenerations;
+    bool intervalDue = m_checkpointInterval.count() > 0 && now - m_lastCheckpoint >= m_checkpointInterval;
+
+    if (!generationsDue && !intervalDue)
+        return false;
+
+    std::scoped_lock lock(m_checkpointMutex);
+    return !m_checkpointBusy;
+}
+
+void Simulation::offerCheckpoint(const std::shared_ptr<const BitBoard> &board)
+{
+    auto now = std::chrono::steady_clock::now();
+
+    // Only a thread that publishes sets m_checkpointBusy, and those take turns, so
+    // it is still clear below.
+    if (!checkpointDue(now))
+        return;
+
+    std::scoped_lock lock(m_checkpointMutex);
+    m_checkpointBoard = board;
+    m_checkpointBusy = true;
+    m_sinceCheckpoint = 0;
+    m_lastCheckpoint = now;
+    m_checkpointCondition.notify_all();
+}
+
+void Simulation::checkpointThread()
+{
+    std::unique_lock lock(m_checkpointMutex);
+    logger.info("The checkpoint thread started, writing to '{}'.", m_checkpointPath);
+
+    while (true)
+    {
+        m_checkpointCondition.wait(lock, [&]
+        {
+            return !m_checkpointRunning || m_checkpointBoard;
+        });
+
+        // A checkpoint handed over before stop() is still written.
+        if (!m_checkpointBoard)
+            break;
+
+        std::shared_ptr<const BitBoard> board = std::move(m_checkpointBoard);
+        lock.unlock();
+
+        size_t bytes = 0;
+        bool failed = false;
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        try
+        {
+            bytes = snapshot::save(*board, m_checkpointPath);
+        }
+        catch (const std::runtime_error &error)
+        {
+            logger.error(error.what());
+            failed = true;
+        }
+
+        auto t2 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> duration = t2 - t1;
+
+        if (!failed)
+            logger.info("Checkpointed {} live chunks of generation {} ({} bytes) in {} ms.", board->size(), board->getGeneration(), bytes, duration.count());
+
+        // Back to the pool before the next board can be pinned.
+        board.reset();
+        lock.lock();
+
+        if (failed)
+        {
+            m_checkpointStats.failed++;
+        }
+        else
+        {
+            m_checkpointStats.written++;
+            m_checkpointStats.lastBytes = bytes;
+            m_checkpointStats.totalBytes += bytes;
+            m_checkpointStats.lastMilliseconds = duration.count();
+            m_checkpointStats.totalMilliseconds += duration.count();
+        }
+
+        m_checkpointBusy = false;
+    }
 }
 
 void Simulation::tickingThread()
@@ -54,33 +515,170 @@ void Simulation::tickingThread()
     try
     {
         std::unique_lock lock(m_tickingMutex);
-        logger.info("The ticking thread started.");
+        logger.info("The ticking thread started with the {} engine.", m_engine->name());
+        m_lastReport = std::chrono::steady_clock::now();
 
         while (m_running)
         {
-            if (!m_paused)
+            // Tasks go first, so that edits scheduled during a tick do not wait for
+            // another one. Edits among them are only collected here.
+            while (!m_taskQueue.empty())
+            {
+                Task task = std::move(m_taskQueue.front());
+                m_taskQueue.pop();
+
+                if (task.edit)
+                {
+                    defer(task.edit, task.scheduled);
+                    continue;
+                }
+
+                // Tasks start from the newest board.
+                lock.unlock();
+                publishAhead();
+
+                auto start = std::chrono::steady_clock::now();
+                std::shared_ptr<const BitBoard> board = task.run();
+                uint64_t nanoseconds = nanosecondsSince(start);
+
+                {
+                    std::scoped_lock statsLock(m_statsMutex);
+                    m_stats.tasks++;
+                    m_stats.taskNanoseconds += nanoseconds;
+                }
+
+                publish(board);
+                lock.lock();
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            const bool advancing = m_advanceLeft > 0;
+            const bool due = advancing || (!m_paused && now >= m_nextTick);
+            const bool soon = advancing || (!m_paused && m_nextTick - now < EditBudget);
+
+            // All the edits collected go out in one pass, with the next tick if that
+            // comes and is done soon enough.
+            if (!m_deferred.empty() && (!soon || m_lastAdvance >= EditBudget))
             {
                 lock.unlock();
-                std::shared_ptr<BitBoard> buffer = acquire();
-                conway::tick(*m_data.load(), *buffer);
-                m_data.store(buffer);
+                publishEdits();
                 lock.lock();
             }
 
-            while (!m_taskQueue.empty())
+            if (due)
             {
-                auto task = m_taskQueue.front();
-                m_taskQueue.pop();
+                unsigned int exponent = m_step;
+
+                if (advancing)
+                {
+                    exponent = std::min(m_step, static_cast<unsigned int>(std::bit_width(m_advanceLeft)) - 1);
+                    m_advanceLeft -= uint64_t{1} << exponent;
+                }
+                else if (m_targetRate > 0.0)
+                {
+                    std::chrono::duration<double> period(static_cast<double>(uint64_t{1} << m_step) / m_targetRate);
+                    m_nextTick = std::max(m_nextTick, now) + std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+                }
+
+                const bool finished = advancing && m_advanceLeft == 0;
+
+                lock.unlock();
+                const bool edited = advance(exponent);
+
+                if (edited || finished || m_wanted.exchange(false, std::memory_order_relaxed) || checkpointDue(std::chrono::steady_clock::now()))
+                    publishAhead();
+
+                report();
+                lock.lock();
+                continue;
+            }
+
+            // Frames show the newest board while the thread waits, unless the wait
+            // is short and no frame asked for it.
+            if (m_ahead && (m_paused || m_wanted.exchange(false, std::memory_order_relaxed) || m_nextTick - now >= EditBudget))
+            {
+                lock.unlock();
+                publishAhead();
+                lock.lock();
+                continue;
+            }
+
+            const bool idle = m_paused || m_nextTick - now >= EditBudget;
+
+            if (!m_ahead && idle && (m_paused || m_spareWanted) && !spareFree())
+            {
+                lock.unlock();
+                prepareSpare();
+                lock.lock();
+                continue;
+            }
+
+            // Everything that changes what is checked above notifies.
+            if (m_paused)
+                m_tickingCondition.wait(lock);
+            else
+                m_tickingCondition.wait_until(lock, m_nextTick);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        logger.error(e.what());
+
+        std::scoped_lock lock(m_exceptionMutex);
+        m_exception = std::current_exception();
+    }
+}
+
+void Simulation::editThread()
+{
+    try
+    {
+        std::unique_lock lock(m_tickingMutex);
+
+        while (m_running)
+        {
+            const bool queued = !m_taskQueue.empty() && m_taskQueue.front().edit;
+            const auto due = m_tickStarted + EditBudget;
 
+            // While the board is being edited, a tick as slow as the last one leaves
+            // time to copy the board it starts from, before edits come in to need it.
+            if (m_ticking && m_spareWanted && m_lastAdvance >= EditBudget && m_latest == m_data.load() && !spareFree())
+            {
+                std::unique_lock lane(m_laneMutex);
                 lock.unlock();
-                m_data.store(task());
+                prepareSpare();
+                lane.unlock();
                 lock.lock();
+                continue;
+            }
+
+            if (!m_ticking || !queued)
+            {
+                m_tickingCondition.wait(lock);
+                continue;
             }
 
-            m_tickingCondition.wait(lock, [&]
+            // A tick that ends before then takes the edits along itself.
+            if (std::chrono::steady_clock::now() < due)
             {
-                return !m_running || !m_paused || !m_taskQueue.empty();
-            });
+                m_tickingCondition.wait_until(lock, due);
+                continue;
+            }
+
+            // Taken while the tick is known to be running, so that it waits for
+            // the pass once it is over.
+            std::unique_lock lane(m_laneMutex);
+
+            while (!m_taskQueue.empty() && m_taskQueue.front().edit)
+            {
+                defer(m_taskQueue.front().edit, m_taskQueue.front().scheduled);
+                m_taskQueue.pop();
+            }
+
+            lock.unlock();
+            publishLaneEdits();
+            lane.unlock();
+            lock.lock();
         }
     }
     catch (const std::exception &e)
@@ -92,19 +690,27 @@ void Simulation::tickingThread()
     }
 }
 
-void Simulation::pushTask(const std::function<std::shared_ptr<const BitBoard>()> &task)
+void Simulation::pushTask(Task task)
 {
     logger.debug("Pushing a new task to the task queue.");
 
     std::scoped_lock lock(m_tickingMutex);
-    m_taskQueue.emplace(task);
+    m_taskQueue.push(std::move(task));
     m_tickingCondition.notify_all();
 }
 
 void Simulation::start()
 {
+    if (!m_checkpointPath.empty())
+    {
+        logger.info("Starting the checkpoint thread...");
+        m_lastCheckpoint = std::chrono::steady_clock::now();
+        m_checkpointThread = std::thread(&Simulation::checkpointThread, this);
+    }
+
     logger.info("Starting the ticking thread...");
     m_thread = std::thread(&Simulation::tickingThread, this);
+    m_editThread = std::thread(&Simulation::editThread, this);
 }
 
 bool Simulation::togglePause()
@@ -118,32 +724,125 @@ bool Simulation::togglePause()
 
 void Simulation::scheduleStep()
 {
-    pushTask([&]()
+    pushTask({.run = [&]()
     {
-        std::shared_ptr<BitBoard> buffer = acquire();
-        conway::tick(*m_data.load(), *buffer);
-        return buffer;
-    });
+        publishEdits();
+        advance(m_step);
+        return std::exchange(m_ahead, nullptr);
+    }});
+}
+
+void Simulation::scheduleAdvance(uint64_t generations)
+{
+    logger.debug("Advancing the simulation by {} generations.", generations);
+
+    std::scoped_lock lock(m_tickingMutex);
+    m_advanceLeft += generations;
+    m_tickingCondition.notify_all();
+}
+
+void Simulation::setTargetRate(double generationsPerSecond)
+{
+    if (generationsPerSecond < 0.0)
+        throw std::invalid_argument("The target rate cannot be negative.");
+
+    std::scoped_lock lock(m_tickingMutex);
+    m_targetRate = generationsPerSecond;
+    m_nextTick = {};
+    m_tickingCondition.notify_all();
 }
 
 void Simulation::scheduleModify(std::function<void(BitBoard &)> func)
 {
-    pushTask([this, func = std::move(func)]()
-    {
-        std::shared_ptr<BitBoard> buffer = acquire();
-        *buffer = *m_data.load();
-        func(*buffer);
-        return buffer;
-    });
+    pushTask({.edit = std::move(func), .scheduled = std::chrono::steady_clock::now()});
 }
 
 void Simulation::scheduleClear()
 {
-    pushTask([&]()
+    pushTask({.run = [&]()
+    {
+        m_deferred.clear();
+        clear();
+        m_engine->invalidate();
+
+        std::shared_ptr<BitBoard> board = acquire();
+        forgetEdits(board);
+        return board;
+    }});
+}
+
+void Simulation::scheduleSave(std::string path)
+{
+    pushTask({.run = [this, path = std::move(path)]()
     {
+        publishEdits();
+        std::shared_ptr<const BitBoard> board = m_data.load();
+
+        try
+        {
+            auto t1 = std::chrono::high_resolution_clock::now();
+            snapshot::save(*board, path);
+            auto t2 = std::chrono::high_resolution_clock::now();
+
+            std::chrono::duration<double, std::milli> duration = t2 - t1;
+            logger.info("Saved {} live chunks of generation {} to '{}' in {} ms.", board->size(), board->getGeneration(), path, duration.count());
+        }
+        catch (const std::runtime_error &error)
+        {
+            logger.error(error.what());
+        }
+
+        return board;
+    }});
+}
+
+void Simulation::scheduleLoad(std::string path)
+{
+    pushTask({.run = [this, path = std::move(path)]() -> std::shared_ptr<const BitBoard>
+    {
+        // A file that fails to load leaves the board with the edits before it.
+        publishEdits();
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        BitBoard board;
+
+        try
+        {
+            snapshot::load(path, board);
+        }
+        catch (const std::runtime_error &error)
+        {
+            logger.error(error.what());
+            return m_data.load();
+        }
+
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        std::chrono::duration<double, std::milli> duration = t2 - t1;
+        logger.info("Loaded {} live chunks of generation {} from '{}' in {} ms.", board.size(), board.getGeneration(), path, duration.count());
+
+        // Pooled boards may be ahead of the loaded generation.
         clear();
-        return acquire();
-    });
+        m_engine->invalidate();
+
+        std::shared_ptr<BitBoard> buffer = acquire();
+        *buffer = std::move(board);
+        forgetEdits(buffer);
+        return buffer;
+    }});
+}
+
+void Simulation::enableCheckpoints(std::string path, uint64_t generations, std::chrono::seconds interval)
+{
+    m_checkpointPath = std::move(path);
+    m_checkpointGenerations = generations;
+    m_checkpointInterval = interval;
+}
+
+void Simulation::trackDensity(bool tracked)
+{
+    std::scoped_lock lock(m_densityMutex);
+    m_densityTracked = tracked;
 }
 
 void Simulation::stop()
@@ -156,4 +855,22 @@ void Simulation::stop()
 
     logger.info("Joining the ticking thread...");
     m_thread.join();
+    m_editThread.join();
+
+    // Edits still waiting for a tick and the board ahead of the published one, so
+    // that the board saved on exit has them.
+    publishEdits();
+    publishAhead();
+
+    if (m_checkpointThread.joinable())
+    {
+        {
+            std::scoped_lock lock(m_checkpointMutex);
+            m_checkpointRunning = false;
+            m_checkpointCondition.notify_all();
+        }
+
+        logger.info("Joining the checkpoint thread...");
+        m_checkpointThread.join();
+    }
 }
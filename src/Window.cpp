@@ -21,7 +21,7 @@ Window::Window(Logger &logger, unsigned int width, unsigned int height, const st
 
     addEventHandler<sf::Event::Resized>([&](const sf::Event::Resized &event)
     {
-        float zoom = view.getSize().x / static_cast<float>(size.x);
+        float zoom = this->zoom();
 
         size = event.size;
         view.setSize(sf::Vector2f(size));
@@ -44,8 +44,8 @@ Window::Window(Logger &logger, unsigned int width, unsigned int height, const st
     {
         if (event.wheel == sf::Mouse::Wheel::Vertical)
         {
-            float zoom = view.getSize().x / static_cast<float>(size.x);
-            float newZoom = std::clamp(zoom * std::powf(0.5F, event.delta), 1.0F / 64.0F, 1.0F);
+            float zoom = this->zoom();
+            float newZoom = std::clamp(zoom * std::powf(0.5F, event.delta), MinZoom, MaxZoom);
             sf::Vector2f originDrift = window.mapPixelToCoords(event.position) - window.getView().getCenter();
             view.move((1 - (newZoom / zoom)) * originDrift);
             view.zoom(newZoom / zoom);
@@ -53,6 +53,12 @@ Window::Window(Logger &logger, unsigned int width, unsigned int height, const st
     });
 }
 
+void Window::handle(const sf::Event &event)
+{
+    for (auto &handler : m_handlers)
+        handler(event);
+}
+
 void Window::run()
 {
     logger.info("Initializing the window...");
@@ -62,14 +68,32 @@ void Window::run()
     {
         logger.info("The window event loop started.");
 
+        bool pending = true; // an event came in since the last frame
+
         while (window.isOpen())
         {
             while (auto event = window.pollEvent())
-                for (auto &handler : m_handlers)
-                    handler(*event);
+            {
+                handle(*event);
+                pending = true;
+            }
 
             update();
 
+            // An unchanged frame is not drawn again, and without display() to wait
+            // for the vertical sync, the loop waits for events instead.
+            if (!pending && !changed())
+            {
+                if (auto event = window.waitEvent(IdleWait))
+                {
+                    handle(*event);
+                    pending = true;
+                }
+
+                continue;
+            }
+
+            pending = false;
             window.clear(background);
             window.setView(view);
 
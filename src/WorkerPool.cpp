@@ -0,0 +1,156 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+WorkerPool::WorkerPool(size_t count)
+{
+    for (size_t worker = 1; worker < count; worker++)
+        m_threads.emplace_back(&WorkerPool::workerThread, this, worker);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::scoped_lock lock(m_mutex);
+        m_running = false;
+        m_startCondition.notify_all();
+    }
+
+    for (auto &thread : m_threads)
+        thread.join();
+}
+
+void WorkerPool::workerThread(size_t worker)
+{
+    // Starting from zero rather than reading m_epoch, so a job posted before this
+    // thread got scheduled is still picked up.
+    size_t epoch = 0;
+    std::unique_lock lock(m_mutex);
+
+    while (true)
+    {
+        m_startCondition.wait(lock, [&]
+        {
+            return !m_running || m_epoch != epoch;
+        });
+
+        if (!m_running)
+            return;
+
+        epoch = m_epoch;
+        const auto &job = *m_job;
+        lock.unlock();
+
+        try
+        {
+            job(worker);
+        }
+        catch (...)
+        {
+            std::scoped_lock exceptionLock(m_mutex);
+            m_exception = std::current_exception();
+        }
+
+        lock.lock();
+
+        if (--m_pending == 0)
+            m_doneCondition.notify_all();
+    }
+}
+
+void WorkerPool::run(const std::function<void(size_t)> &job)
+{
+    if (m_threads.empty())
+    {
+        job(0);
+        return;
+    }
+
+    {
+        std::scoped_lock lock(m_mutex);
+        m_job = &job;
+        m_pending = m_threads.size();
+        m_epoch++;
+        m_startCondition.notify_all();
+    }
+
+    std::exception_ptr exception;
+
+    try
+    {
+        job(0);
+    }
+    catch (...)
+    {
+        exception = std::current_exception();
+    }
+
+    std::unique_lock lock(m_mutex);
+    m_doneCondition.wait(lock, [&]
+    {
+        return m_pending == 0;
+    });
+
+    m_job = nullptr;
+
+    if (!exception)
+        std::swap(exception, m_exception);
+
+    m_exception = nullptr;
+
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
+void WorkerPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t, size_t)> &body)
+{
+    struct alignas(64) Range
+    {
+        std::atomic<size_t> next;
+        size_t end;
+    };
+
+    const size_t workers = size();
+    grain = std::max<size_t>(grain, 1);
+
+    if (workers == 1 || count <= grain)
+    {
+        if (count > 0)
+            body(0, 0, count);
+
+        return;
+    }
+
+    const size_t blocks = (count + grain - 1) / grain;
+    std::vector<Range> ranges(workers);
+
+    for (size_t worker = 0; worker < workers; worker++)
+    {
+        ranges[worker].next.store(std::min(count, (blocks * worker / workers) * grain), std::memory_order_relaxed);
+        ranges[worker].end = std::min(count, (blocks * (worker + 1) / workers) * grain);
+    }
+
+    run([&](size_t worker)
+    {
+        for (size_t i = 0; i < workers; i++)
+        {
+            Range &range = ranges[(worker + i) % workers];
+
+            while (true)
+            {
+                size_t begin = range.next.fetch_add(grain, std::memory_order_relaxed);
+                if (begin >= range.end)
+                    break;
+
+                body(worker, begin, std::min(begin + grain, range.end));
+            }
+        }
+    });
+}
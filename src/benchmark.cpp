@@ -0,0 +1,251 @@
+#include "benchmark.hpp"
+#include "BitBoard.hpp"
+#include "Engine.hpp"
+#include "Logger.hpp"
+#include "conway.hpp"
+#include "kernel.hpp"
+#include "pattern.hpp"
+
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <ratio>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr std::string_view RPentomino = "b2o$2o$bo!";
+    constexpr std::string_view Acorn = "bo$3bo$2o2b3o!";
+    constexpr std::string_view GosperGun = "24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4bobo$10bo5bo7bo$11bo3bo$12b2o!";
+
+    void seedRle(BitBoard &board, std::string_view rle, sf::Vector2i origin = {0, 0})
+    {
+        std::istringstream input{std::string(rle)};
+        pattern::read(input, pattern::Format::Rle, board, origin);
+    }
+
+    // Guns far enough apart that each one fires for a while before its gliders
+    // reach the next.
+    void seedGuns(BitBoard &board)
+    {
+        constexpr int Count = 8;
+        constexpr int Spacing = 320;
+
+        for (int y = 0; y < Count; y++)
+            for (int x = 0; x < Count; x++)
+                seedRle(board, GosperGun, {x * Spacing, y * Spacing});
+    }
+
+    // The single line of cells --benchmark used to time on its own.
+    void seedStripe(BitBoard &board)
+    {
+        constexpr int StripeLength = 2048;
+
+        for (int i = 0; i < StripeLength; i++)
+            board.set({i, 0}, true);
+    }
+
+    // Nearest rank, so that the value is always one of the samples.
+    [[nodiscard]] double percentile(const std::vector<double> &sorted, double fraction)
+    {
+        auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    [[nodiscard]] double median(const std::vector<double> &sorted)
+    {
+        size_t middle = sorted.size() / 2;
+
+        if (sorted.size() % 2)
+            return sorted[middle];
+
+        return (sorted[middle - 1] + sorted[middle]) / 2.0;
+    }
+
+    void writeString(std::ostream &out, std::string_view value)
+    {
+        out << '"';
+
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20)
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+            else
+                out << c;
+        }
+
+        out << '"';
+    }
+}
+
+namespace benchmark
+{
+    const std::vector<Workload> &workloads()
+    {
+        static const std::vector<Workload> Workloads = {
+            {"r-pentomino", "R-pentomino, a methuselah that settles after 1103 generations", [](BitBoard &board) { seedRle(board, RPentomino); }},
+            {"acorn", "Acorn, a methuselah that settles after 5206 generations", [](BitBoard &board) { seedRle(board, Acorn); }},
+            {"soup-20", "512x512 random soup at 20% density", [](BitBoard &board) { seedSoup(board, 0.2); }},
+            {"soup-35", "512x512 random soup at 35% density", [](BitBoard &board) { seedSoup(board, 0.35); }},
+            {"soup-50", "512x512 random soup at 50% density", [](BitBoard &board) { seedSoup(board, 0.5); }},
+            {"guns", "8x8 field of Gosper glider guns", seedGuns},
+            {"gliders", "32x32 sparse cloud of gliders", [](BitBoard &board) { seedGliders(board); }},
+            {"stripe", "2048-cell horizontal stripe", seedStripe},
+        };
+
+        return Workloads;
+    }
+
+    const Workload *find(std::string_view name)
+    {
+        const auto &all = workloads();
+        auto it = std::find_if(all.begin(), all.end(), [&](const Workload &workload) { return workload.name == name; });
+        return it != all.end() ? &*it : nullptr;
+    }
+
+    Result run(const Workload &workload, const Settings &settings, Logger &logger)
+    {
+        Result result;
+        result.workload = workload.name;
+
+        logger.info("Running the {} workload with {} warmup and {} timed trials of {} advances.", workload.name, settings.warmup, settings.trials, settings.generations);
+
+        for (unsigned int trial = 0; trial < settings.warmup + settings.trials; trial++)
+        {
+            std::unique_ptr<Engine> engine = makeEngine(settings.engine, settings.threads, settings.rule);
+            BitBoard firstBoard;
+            BitBoard secondBoard;
+            workload.seed(secondBoard);
+
+            // Swapped by pointer, so an engine that keeps state for the board it wrote
+            // last is timed with that state.
+            BitBoard *previousBoard = &firstBoard;
+            BitBoard *currentBoard = &secondBoard;
+
+            auto t1 = std::chrono::high_resolution_clock::now();
+            for (unsigned int i = 0; i < settings.generations; i++)
+            {
+                std::swap(previousBoard, currentBoard);
+                engine->advance(*previousBoard, *currentBoard, settings.step);
+            }
+            auto t2 = std::chrono::high_resolution_clock::now();
+
+            std::chrono::duration<double, std::milli> duration = t2 - t1;
+            logger.debug("Trial {} of the {} workload took {} ms.", trial, workload.name, duration.count());
+
+            result.engine = engine->name();
+
+            if (trial < settings.warmup)
+                continue;
+
+            result.milliseconds.push_back(duration.count());
+            result.chunks = currentBoard->size();
+            result.bytes = currentBoard->bytes();
+            result.counters = engine->counters();
+            result.board = std::move(*currentBoard);
+        }
+
+        if (result.milliseconds.empty())
+            return result;
+
+        std::vector<double> sorted = result.milliseconds;
+        std::sort(sorted.begin(), sorted.end());
+
+        result.median = median(sorted);
+        result.p95 = percentile(sorted, 0.95);
+
+        double generations = static_cast<double>(uint64_t{settings.generations} << settings.step);
+        result.generationsPerSecond = result.median > 0.0 ? 1000.0 * generations / result.median : 0.0;
+
+        return result;
+    }
+
+    void writeText(std::ostream &out, const Settings &settings, const std::vector<Result> &results)
+    {
+        uint64_t generations = uint64_t{settings.generations} << settings.step;
+
+        for (const auto &result : results)
+        {
+            out << "Workload " << result.workload << ": " << generations << " generations of " << kernel::notation(settings.rule) << " on the " << result.engine << " engine in " << result.median << " ms median, " << result.p95 << " ms p95 over " << result.milliseconds.size() << " trials\n";
+            out << "  " << result.generationsPerSecond << " generations per second, ending with " << result.chunks << " live chunks in " << result.bytes << " bytes\n";
+
+            if (conway::Counters counters = result.counters; counters.computed + counters.skipped > 0)
+            {
+                double skippedShare = 100.0 * static_cast<double>(counters.skipped) / static_cast<double>(counters.computed + counters.skipped);
+                out << "  Computed " << counters.computed << " chunks and skipped " << counters.skipped << " settled ones (" << skippedShare << "%)\n";
+
+                double probesPerAllocation = counters.allocated > 0 ? static_cast<double>(counters.probes) / static_cast<double>(counters.allocated) : 0.0;
+                out << "  Allocated " << counters.allocated << " chunk slots with " << probesPerAllocation << " bitmap probes each\n";
+                out << "  " << counters.births << " chunk births, " << counters.deaths << " deaths and " << counters.lookups << " map lookups\n";
+
+                const conway::Timings &phases = counters.nanoseconds;
+                out << "  Phases took " << (static_cast<double>(phases.live) / 1e6) << " ms live, " << (static_cast<double>(phases.candidates) / 1e6) << " ms candidates, " << (static_cast<double>(phases.writeBack) / 1e6) << " ms write back, ";
+                out << (static_cast<double>(phases.insert) / 1e6) << " ms insert, " << (static_cast<double>(phases.frontier) / 1e6) << " ms frontier, " << (static_cast<double>(phases.relayout) / 1e6) << " ms relayout\n";
+            }
+        }
+    }
+
+    void writeJson(std::ostream &out, const Settings &settings, const std::vector<Result> &results)
+    {
+        out << "{\n";
+        out << "  \"kernel\": ";
+        writeString(out, kernel::name(kernel::selected()));
+        out << ",\n  \"rule\": ";
+        writeString(out, kernel::notation(settings.rule));
+        out << ",\n  \"threads\": " << settings.threads;
+        out << ",\n  \"step\": " << settings.step;
+        out << ",\n  \"advances\": " << settings.generations;
+        out << ",\n  \"generations\": " << (uint64_t{settings.generations} << settings.step);
+        out << ",\n  \"warmup\": " << settings.warmup;
+        out << ",\n  \"trials\": " << settings.trials;
+        out << ",\n  \"results\": [";
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result &result = results[i];
+
+            out << (i > 0 ? "," : "") << "\n    {\n      \"workload\": ";
+            writeString(out, result.workload);
+            out << ",\n      \"engine\": ";
+            writeString(out, result.engine);
+            out << ",\n      \"milliseconds\": [";
+
+            for (size_t j = 0; j < result.milliseconds.size(); j++)
+                out << (j > 0 ? ", " : "") << result.milliseconds[j];
+
+            out << "],\n      \"median_ms\": " << result.median;
+            out << ",\n      \"p95_ms\": " << result.p95;
+            out << ",\n      \"generations_per_second\": " << result.generationsPerSecond;
+            out << ",\n      \"live_chunks\": " << result.chunks;
+            out << ",\n      \"bytes\": " << result.bytes;
+            out << ",\n      \"computed\": " << result.counters.computed;
+            out << ",\n      \"skipped\": " << result.counters.skipped;
+            out << ",\n      \"allocated\": " << result.counters.allocated;
+            out << ",\n      \"probes\": " << result.counters.probes;
+            out << ",\n      \"live\": " << result.counters.live;
+            out << ",\n      \"candidates\": " << result.counters.candidates;
+            out << ",\n      \"births\": " << result.counters.births;
+            out << ",\n      \"deaths\": " << result.counters.deaths;
+            out << ",\n      \"lookups\": " << result.counters.lookups;
+
+            const conway::Timings &phases = result.counters.nanoseconds;
+            out << ",\n      \"phase_ns\": {\"live\": " << phases.live << ", \"candidates\": " << phases.candidates << ", \"write_back\": " << phases.writeBack;
+            out << ", \"insert\": " << phases.insert << ", \"frontier\": " << phases.frontier << ", \"relayout\": " << phases.relayout << "}";
+            out << "\n    }";
+        }
+
+        out << "\n  ]\n}\n";
+    }
+}
@@ -0,0 +1,301 @@
+#include "commands.hpp"
+#include "BitBoard.hpp"
+#include "Chunk.hpp"
+#include "Engine.hpp"
+#include "Logger.hpp"
+#include "Options.hpp"
+#include "Simulation.hpp"
+#include "WorkerPool.hpp"
+#include "benchmark.hpp"
+#include "conway.hpp"
+#include "kernel.hpp"
+#include "pattern.hpp"
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <ratio>
+#include <string_view>
+#include <syncstream>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr std::array<unsigned int, 4> TileSizes = {8, 16, 32, 64};
+
+    // Generations per second on N x N tiles.
+    template <unsigned int N, typename Seed>
+    double tileThroughput(WorkerPool &pool, const kernel::Rule &rule, Seed seed, int generations)
+    {
+        BasicBitBoard<BasicChunk<N>> previousBoard;
+        BasicBitBoard<BasicChunk<N>> currentBoard;
+        seed(currentBoard);
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < generations; i++)
+        {
+            std::swap(previousBoard, currentBoard);
+            conway::tick(previousBoard, currentBoard, pool, rule);
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        std::chrono::duration<double> duration = t2 - t1;
+        return static_cast<double>(generations) / duration.count();
+    }
+
+    // Live cells of a board and the smallest rectangle holding them.
+    struct Population
+    {
+        uint64_t cells = 0;
+        size_t chunks = 0;
+        int left = std::numeric_limits<int>::max();
+        int top = std::numeric_limits<int>::max();
+        int right = std::numeric_limits<int>::min();
+        int bottom = std::numeric_limits<int>::min();
+    };
+
+    [[nodiscard]] Population census(const BitBoard &board)
+    {
+        constexpr int Size = Chunk::Size;
+        Population population;
+
+        for (const auto &[chunk, pos] : board)
+        {
+            if (!chunk)
+                continue;
+
+            uint64_t data = chunk.data();
+            uint64_t columns = 0;
+
+            for (int y = 0; y < Size; y++)
+                columns |= (data >> (y * Size)) & 0xFFU;
+
+            const int firstRow = std::countr_zero(data) / Size;
+            const int lastRow = (63 - std::countl_zero(data)) / Size;
+
+            population.cells += static_cast<uint64_t>(std::popcount(data));
+            population.chunks++;
+            population.left = std::min(population.left, (pos.x * Size) + std::countr_zero(columns));
+            population.right = std::max(population.right, (pos.x * Size) + (63 - std::countl_zero(columns)));
+            population.top = std::min(population.top, (pos.y * Size) + firstRow);
+            population.bottom = std::max(population.bottom, (pos.y * Size) + lastRow);
+        }
+
+        return population;
+    }
+}
+
+namespace commands
+{
+    BitBoard loadBoard(const Options &options, Logger &logger)
+    {
+        BitBoard board;
+
+        if (options.snapshot)
+        {
+            auto t1 = std::chrono::high_resolution_clock::now();
+            snapshot::load(*options.snapshot, board);
+            auto t2 = std::chrono::high_resolution_clock::now();
+
+            std::chrono::duration<double, std::milli> duration = t2 - t1;
+            logger.info("Loaded snapshot '{}' of generation {} with {} live chunks in {} ms.", *options.snapshot, board.getGeneration(), board.size(), duration.count());
+        }
+
+        for (const auto &path : options.patterns)
+        {
+            auto t1 = std::chrono::high_resolution_clock::now();
+            pattern::load(path, board);
+            auto t2 = std::chrono::high_resolution_clock::now();
+
+            std::chrono::duration<double, std::milli> duration = t2 - t1;
+            logger.info("Loaded '{}' in {} ms, the board now has {} live chunks.", path, duration.count(), board.size());
+        }
+
+        return board;
+    }
+
+    void runBenchmark(const Options &options, Logger &logger)
+    {
+        benchmark::Settings settings = {options.engine, options.threads, options.step, options.generations, options.warmup, options.trials, options.rule};
+        std::vector<benchmark::Workload> workloads;
+
+        // Loaded patterns are timed instead of the built-in workloads, unless some
+        // of those are asked for as well.
+        if (options.snapshot || !options.patterns.empty())
+        {
+            auto board = std::make_shared<const BitBoard>(loadBoard(options, logger));
+            workloads.push_back({"loaded", "patterns from the command line", [board](BitBoard &target) { target = *board; }});
+        }
+
+        for (const auto &name : options.workloads)
+            workloads.push_back(*benchmark::find(name));
+
+        if (workloads.empty())
+            workloads = benchmark::workloads();
+
+        logger.info("Starting benchmark of {} workloads with {} advances of 2^{} generations of {} on {} threads.", workloads.size(), settings.generations, settings.step, kernel::notation(settings.rule), settings.threads);
+
+        std::vector<benchmark::Result> results;
+
+        for (const auto &workload : workloads)
+            results.push_back(benchmark::run(workload, settings, logger));
+
+        std::osyncstream stream(std::cout);
+
+        if (options.json)
+            benchmark::writeJson(stream, settings, results);
+        else
+            benchmark::writeText(stream, settings, results);
+
+        stream.emit();
+
+        if (options.save)
+        {
+            auto t1 = std::chrono::high_resolution_clock::now();
+            snapshot::save(results.back().board, *options.save);
+            auto t2 = std::chrono::high_resolution_clock::now();
+
+            std::chrono::duration<double, std::milli> duration = t2 - t1;
+            logger.info("Saved the final board of the {} workload to '{}' in {} ms.", results.back().workload, *options.save, duration.count());
+        }
+    }
+
+    void compareTileSizes(const Options &options, Logger &logger)
+    {
+        constexpr int Generations = 200;
+
+        WorkerPool pool(options.threads);
+
+        auto compare = [&](std::string_view workload, auto seed)
+        {
+            logger.debug("Timing {} generations of the {} workload for every tile size.", Generations, workload);
+
+            std::array<double, TileSizes.size()> throughput = {
+                tileThroughput<8>(pool, options.rule, seed, Generations),
+                tileThroughput<16>(pool, options.rule, seed, Generations),
+                tileThroughput<32>(pool, options.rule, seed, Generations),
+                tileThroughput<64>(pool, options.rule, seed, Generations),
+            };
+
+            size_t best = 0;
+
+            std::osyncstream stream(std::cout);
+
+            for (size_t i = 0; i < TileSizes.size(); i++)
+            {
+                stream << "Tile " << TileSizes[i] << 'x' << TileSizes[i] << " runs the " << workload << " workload at " << throughput[i] << " generations per second\n";
+
+                if (throughput[i] > throughput[best])
+                    best = i;
+            }
+
+            stream << "The " << workload << " workload is fastest with " << TileSizes[best] << 'x' << TileSizes[best] << " tiles\n";
+        };
+
+        compare("dense", [](auto &board) { benchmark::seedSoup(board, 0.5); });
+        compare("sparse", [](auto &board) { benchmark::seedGliders(board); });
+    }
+
+    void runHeadless(const Options &options, Logger &logger)
+    {
+        const uint64_t generations = *options.run;
+
+        std::unique_ptr<Engine> engine = makeEngine(options.engine, options.threads, options.rule);
+        // HashLife keeps its tree for the board it wrote last, so the two boards
+        // trade places by pointer rather than by contents.
+        BitBoard firstBoard;
+        BitBoard secondBoard = loadBoard(options, logger);
+        BitBoard *previousBoard = &firstBoard;
+        BitBoard *currentBoard = &secondBoard;
+
+        logger.info("Running {} generations of {} in steps of up to 2^{} on the {} engine with {} threads.", generations, kernel::notation(options.rule), options.step, engine->name(), options.threads);
+
+        auto start = std::chrono::steady_clock::now();
+        auto lastReport = start;
+        auto lastCheckpoint = start;
+        uint64_t done = 0;
+        uint64_t sinceCheckpoint = 0;
+
+        while (done < generations)
+        {
+            // The last steps are shortened to land on the requested generation.
+            unsigned int exponent = options.step;
+
+            while ((uint64_t{1} << exponent) > generations - done)
+                exponent--;
+
+            std::swap(previousBoard, currentBoard);
+            engine->advance(*previousBoard, *currentBoard, exponent);
+            done += uint64_t{1} << exponent;
+            sinceCheckpoint += uint64_t{1} << exponent;
+
+            auto now = std::chrono::steady_clock::now();
+
+            if (now - lastReport >= Simulation::ReportInterval)
+            {
+                lastReport = now;
+                logger.info("Reached generation {} of {} with {} live chunks.", done, generations, currentBoard->size());
+            }
+
+            // Without a window there is nothing to keep responsive, so checkpoints
+            // are written in line.
+            bool checkpointDue = (options.checkpointGenerations > 0 && sinceCheckpoint >= options.checkpointGenerations) || (options.checkpointSeconds > 0 && now - lastCheckpoint >= std::chrono::seconds(options.checkpointSeconds));
+
+            if (options.checkpoint && checkpointDue && done < generations)
+            {
+                size_t bytes = snapshot::save(*currentBoard, *options.checkpoint);
+                logger.info("Checkpointed generation {} ({} bytes) to '{}'.", done, bytes, *options.checkpoint);
+
+                lastCheckpoint = std::chrono::steady_clock::now();
+                sinceCheckpoint = 0;
+            }
+        }
+
+        std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+        double generationsPerSecond = duration.count() > 0.0 ? 1000.0 * static_cast<double>(generations) / duration.count() : 0.0;
+        Population population = census(*currentBoard);
+
+        std::osyncstream stream(std::cout);
+
+        if (options.json)
+        {
+            stream << "{\n";
+            stream << "  \"engine\": \"" << engine->name() << "\",\n";
+            stream << "  \"rule\": \"" << kernel::notation(options.rule) << "\",\n";
+            stream << "  \"generations\": " << generations << ",\n";
+            stream << "  \"milliseconds\": " << duration.count() << ",\n";
+            stream << "  \"generations_per_second\": " << generationsPerSecond << ",\n";
+            stream << "  \"population\": " << population.cells << ",\n";
+            stream << "  \"live_chunks\": " << population.chunks;
+
+            if (population.cells > 0)
+                stream << ",\n  \"bounds\": {\"left\": " << population.left << ", \"top\": " << population.top << ", \"right\": " << population.right << ", \"bottom\": " << population.bottom << "}";
+
+            stream << "\n}\n";
+        }
+        else
+        {
+            stream << "Ran " << generations << " generations of " << kernel::notation(options.rule) << " on the " << engine->name() << " engine in " << duration.count() << " ms (" << generationsPerSecond << " generations per second)\n";
+            stream << "Population is " << population.cells << " cells in " << population.chunks << " live chunks\n";
+
+            if (population.cells > 0)
+                stream << "Bounding box spans (" << population.left << ", " << population.top << ") to (" << population.right << ", " << population.bottom << ")\n";
+        }
+
+        stream.emit();
+
+        if (options.save)
+        {
+            size_t bytes = snapshot::save(*currentBoard, *options.save);
+            logger.info("Saved the final board ({} bytes) to '{}'.", bytes, *options.save);
+        }
+    }
+}
@@ -2,180 +2,424 @@
 #include "BitBoard.hpp"
 #include "Chunk.hpp"
 #include "Direction.hpp"
+#include "WorkerPool.hpp"
+#include "kernel.hpp"
 
 #include <SFML/System/Vector2.hpp>
-#include <boost/unordered/unordered_flat_map.hpp>
-#include <tuple>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
 
 namespace
 {
-    [[nodiscard]] constexpr std::tuple<Chunk, Chunk> halfAdder(Chunk a, Chunk b)
+    template <typename ChunkT>
+    struct Result
     {
-        return {a ^ b, a & b};
-    }
+        typename BasicBitBoard<ChunkT>::ChunkPos pos;
+        typename BasicBitBoard<ChunkT>::Index slot;
+        ChunkT chunk;
+        ChunkT previous;
+        uint8_t activity;
+    };
 
-    [[nodiscard]] constexpr std::tuple<Chunk, Chunk> fullAdder(Chunk a, Chunk b, Chunk c)
+    // Per-worker scratch space. It outlives the tick, so the vectors keep their
+    // capacity and a steady-state tick does not allocate.
+    template <typename ChunkT>
+    struct Scratch
     {
-        Chunk s = a ^ b;
-        return {s ^ c, (a & b) | (s & c)};
-    }
+        std::vector<Result<ChunkT>> results;
+        std::vector<typename BasicBitBoard<ChunkT>::Index> frontier;
+        std::vector<typename BasicBitBoard<ChunkT>::ChunkPos> unmapped;
+        size_t revived = 0;
+        conway::Counters counters;
+        kernel::Rule rule;
+
+        void reset(const kernel::Rule &tickRule)
+        {
+            results.clear();
+            frontier.clear();
+            unmapped.clear();
+            revived = 0;
+            counters = {};
+            rule = tickRule;
+        }
+    };
 
-    [[nodiscard]] constexpr std::tuple<Chunk, Chunk, Chunk> adder2(Chunk a0, Chunk a1, Chunk b0, Chunk b1)
+    // Larger tiles are evolved as soon as their neighbourhood is gathered.
+    template <typename ChunkT>
+    struct Worker : Scratch<ChunkT>
     {
-        auto [s0, c0] = halfAdder(a0, b0);
-        auto [s1, c1] = fullAdder(a1, b1, c0);
-        return {s0, s1, c1};
-    }
+    };
 
-    [[nodiscard]] constexpr std::tuple<Chunk, Chunk, Chunk, Chunk> adder3(Chunk a0, Chunk a1, Chunk a2, Chunk b0, Chunk b1, Chunk b2)
+    // 8x8 neighbourhoods are staged into a batch for the vectorized kernel.
+    template <>
+    struct Worker<Chunk> : Scratch<Chunk>
     {
-        auto [s0, c0] = halfAdder(a0, b0);
-        auto [s1, c1] = fullAdder(a1, b1, c0);
-        auto [s2, c2] = fullAdder(a2, b2, c1);
-        return {s0, s1, s2, c2};
+        kernel::Batch batch;
+        std::array<BitBoard::ChunkPos, kernel::Batch::Capacity> positions;
+        std::array<Chunk, kernel::Batch::Capacity> previous;
+        std::array<uint64_t, kernel::Batch::Capacity> evolved;
+    };
+
+    constexpr size_t Grain = 256;
+
+    // Same adder network as the chunk kernel, over one row of a tile at a time.
+    // Rows are widened to 64 bits; bits shifted past the tile width only ever feed
+    // bits past the tile width, so a single mask at the end is enough.
+    template <unsigned int N>
+    [[nodiscard]] BasicChunk<N> evolve(const std::array<const BasicChunk<N> *, 9> &tiles, const kernel::Rule &rule)
+    {
+        using Row = typename BasicChunk<N>::Row;
+
+        // Row y of the west, centre and east tiles; -1 and N reach into the tiles
+        // to the north and south.
+        auto band = [&](int y) -> std::array<uint64_t, 3>
+        {
+            if (y < 0)
+                return {tiles[Direction::NorthWest]->row(N - 1), tiles[Direction::North]->row(N - 1), tiles[Direction::NorthEast]->row(N - 1)};
+
+            if (y == static_cast<int>(N))
+                return {tiles[Direction::SouthWest]->row(0), tiles[Direction::South]->row(0), tiles[Direction::SouthEast]->row(0)};
+
+            auto row = static_cast<unsigned int>(y);
+            return {tiles[Direction::West]->row(row), tiles[kernel::Batch::Center]->row(row), tiles[Direction::East]->row(row)};
+        };
+
+        auto left = [](const std::array<uint64_t, 3> &words)
+        {
+            return (words[1] << 1) | (words[0] >> (N - 1));
+        };
+
+        auto right = [](const std::array<uint64_t, 3> &words)
+        {
+            return (words[1] >> 1) | (words[2] << (N - 1));
+        };
+
+        BasicChunk<N> result;
+
+        kernel::withRule(rule, [&](auto next)
+        {
+            std::array<uint64_t, 3> above = band(-1);
+            std::array<uint64_t, 3> middle = band(0);
+
+            for (unsigned int y = 0; y < N; y++)
+            {
+                std::array<uint64_t, 3> below = band(static_cast<int>(y) + 1);
+
+                auto [s01, c01] = kernel::halfAdder(left(middle), right(middle));
+                auto [s23, c23] = kernel::halfAdder(above[1], below[1]);
+                auto [s45, c45] = kernel::halfAdder(left(above), left(below));
+                auto [s67, c67] = kernel::halfAdder(right(above), right(below));
+                auto [q00, q01, c0] = kernel::adder2(s01, c01, s23, c23);
+                auto [q10, q11, c1] = kernel::adder2(s45, c45, s67, c67);
+                auto [r0, r1, r2, r3] = kernel::adder3(q00, q01, c0, q10, q11, c1);
+
+                result.setRow(y, static_cast<Row>(next(middle[1], r0, r1, r2, r3)));
+                above = middle;
+                middle = below;
+            }
+        });
+
+        return result;
     }
 
-    [[nodiscard]] inline Chunk process(const BitBoard &board, Chunk chunk, const BitBoard::Meta &meta, boost::unordered::unordered_flat_map<sf::Vector2i, BitBoard::Meta> *potentialChunks = nullptr)
+    // Records the next state of a chunk. Empty chunks are only kept while they
+    // still differ from one of the two generations before.
+    template <typename ChunkT>
+    void emit(Worker<ChunkT> &self, const BasicBitBoard<ChunkT> &current, sf::Vector2i pos, const ChunkT &next, const ChunkT &chunk, const ChunkT &previous)
     {
-        Chunk x0 = chunk.shiftRight(); // left neighbor
-        Chunk x1 = chunk.shiftLeft();  // right neighbor
-        Chunk x2 = chunk.shiftDown();  // upper neighbor
-        Chunk x3 = chunk.shiftUp();    // lower neighbor
-        Chunk x4 = x0.shiftDown();     // upper left neighbor
-        Chunk x5 = x0.shiftUp();       // lower left neighbor
-        Chunk x6 = x1.shiftDown();     // upper right neighbor
-        Chunk x7 = x1.shiftUp();       // lower right neighbor
-
-        if (auto other = board.at(meta.neighbors[Direction::North]); other != board.end())
-        {
-            Chunk y = other->node.chunk.shiftUp(7);
-            x2 |= y;
-            x6 |= y.shiftLeft();
-            x4 |= y.shiftRight();
-        }
-        else if (potentialChunks && chunk.shiftDown(7))
+        using Board = BasicBitBoard<ChunkT>;
+
+        auto activity = static_cast<uint8_t>((next != chunk ? Board::ChangedOne : 0) | (next != previous ? Board::ChangedTwo : 0));
+
+        if (next && !chunk)
+            self.counters.births++;
+        else if (chunk && !next)
+            self.counters.deaths++;
+
+        if (next || activity)
         {
-            Direction direction = Direction::North;
-            auto [entry, inserted] = potentialChunks->try_emplace(direction.offset(meta.pos), 0, direction.offset(meta.pos));
-            entry->second.neighbors[direction.opposite()] = meta.index; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            self.counters.lookups++;
+            self.results.push_back({pos, current.locate(pos), next, chunk, activity});
         }
+    }
 
-        if (auto other = board.at(meta.neighbors[Direction::South]); other != board.end())
+    template <typename ChunkT>
+    void flush(Worker<ChunkT> &self, const BasicBitBoard<ChunkT> &current)
+    {
+        if constexpr (std::is_same_v<ChunkT, Chunk>)
         {
-            Chunk y = other->node.chunk.shiftDown(7);
-            x3 |= y;
-            x7 |= y.shiftLeft();
-            x5 |= y.shiftRight();
+            kernel::evolve(self.batch, self.evolved, self.rule);
+
+            for (size_t lane = 0; lane < self.batch.size; lane++)
+                emit(self, current, self.positions[lane], Chunk(self.evolved[lane]), Chunk(self.batch.words[kernel::Batch::Center][lane]), self.previous[lane]);
+
+            self.batch.size = 0;
         }
-        else if (potentialChunks && chunk.shiftUp(7))
+    }
+
+    // Settled neighbourhoods are copied forward: if none of the nine chunks changed
+    // in the last generation, the next one repeats the current one, and if none
+    // changed over the last two, it repeats the one before. Otherwise the chunk goes
+    // into the next lane of the worker's batch, or is evolved right away for larger
+    // tiles. The activity of a board that was edited does not describe a real
+    // generation step, so a board needs that many ticks of history for either rule.
+    // A stale slot stands for a birth candidate: empty, and empty for the two
+    // generations before.
+    template <typename ChunkT>
+    void gather(Worker<ChunkT> &self, const BasicBitBoard<ChunkT> &board, const BasicBitBoard<ChunkT> &current, typename BasicBitBoard<ChunkT>::Index index)
+    {
+        using Board = BasicBitBoard<ChunkT>;
+
+        static constexpr ChunkT Empty;
+        const bool live = board.live(index);
+        const ChunkT &chunk = live ? board.chunk(index) : Empty;
+        const ChunkT &previous = live ? board.previous(index) : Empty;
+        const typename Board::Neighbors &neighbors = board.neighbors(index);
+        const typename Board::ChunkPos pos = board.position(index);
+
+        std::array<const ChunkT *, 9> tiles; // NOLINT(cppcoreguidelines-pro-type-member-init)
+        tiles[kernel::Batch::Center] = &chunk;
+        uint8_t activity = live ? board.activity(index) : 0;
+
+        for (auto direction : Direction::All)
         {
-            Direction direction = Direction::South;
-            auto [entry, inserted] = potentialChunks->try_emplace(direction.offset(meta.pos), 0, direction.offset(meta.pos));
-            entry->second.neighbors[direction.opposite()] = meta.index; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            if (auto other = neighbors[direction]; board.live(other)) // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            {
+                tiles[direction] = &board.chunk(other); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+                activity |= board.activity(other);
+            }
+            else
+            {
+                tiles[direction] = &Empty; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            }
         }
 
-        if (auto other = board.at(meta.neighbors[Direction::West]); other != board.end())
+        if (board.history() >= 1 && !(activity & Board::ChangedOne))
         {
-            Chunk y = other->node.chunk.shiftLeft(7);
-            x0 |= y;
-            x4 |= y.shiftDown();
-            x5 |= y.shiftUp();
+            self.counters.skipped++;
+            emit(self, current, pos, chunk, chunk, previous);
+            return;
         }
-        else if (potentialChunks && chunk.shiftRight(7))
+
+        if (board.history() >= 2 && !(activity & Board::ChangedTwo))
         {
-            Direction direction = Direction::West;
-            auto [entry, inserted] = potentialChunks->try_emplace(direction.offset(meta.pos), 0, direction.offset(meta.pos));
-            entry->second.neighbors[direction.opposite()] = meta.index; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            self.counters.skipped++;
+            emit(self, current, pos, previous, chunk, previous);
+            return;
         }
 
-        if (auto other = board.at(meta.neighbors[Direction::East]); other != board.end())
+        self.counters.computed++;
+
+        if constexpr (std::is_same_v<ChunkT, Chunk>)
         {
-            Chunk y = other->node.chunk.shiftRight(7);
-            x1 |= y;
-            x6 |= y.shiftDown();
-            x7 |= y.shiftUp();
+            size_t lane = self.batch.size++;
+            self.positions[lane] = pos;
+            self.previous[lane] = previous;
+
+            for (size_t position = 0; position < tiles.size(); position++)
+                self.batch.words[position][lane] = tiles[position]->data(); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+
+            if (self.batch.size == kernel::Batch::Capacity)
+                flush(self, current);
         }
-        else if (potentialChunks && chunk.shiftLeft(7))
+        else
         {
-            Direction direction = Direction::East;
-            auto [entry, inserted] = potentialChunks->try_emplace(direction.offset(meta.pos), 0, direction.offset(meta.pos));
-            entry->second.neighbors[direction.opposite()] = meta.index; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            emit(self, current, pos, evolve(tiles, self.rule), chunk, previous);
         }
+    }
+
+    // Collects the frontier of a live chunk. Stale neighbors are claimed right away;
+    // neighbors without a slot need one allocated, which has to wait.
+    template <typename ChunkT>
+    void collectFrontier(Worker<ChunkT> &self, BasicBitBoard<ChunkT> &current, typename BasicBitBoard<ChunkT>::Index index)
+    {
+        const ChunkT &chunk = current.chunk(index);
 
-        if (auto other = board.at(meta.neighbors[Direction::NorthWest]); other != board.end())
+        for (auto direction : Direction::All)
         {
-            Chunk y = other->node.chunk.shiftLeft(7).shiftUp(7);
-            x4 |= y;
+            if (!(chunk & ChunkT::edge(direction)))
+                continue;
+
+            auto other = current.neighbors(index)[direction]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+
+            if (other == BasicBitBoard<ChunkT>::Invalid)
+                self.unmapped.push_back(direction.offset(current.position(index)));
+            else if (current.claimFrontier(other))
+                self.frontier.push_back(other);
         }
-        else if (potentialChunks && chunk.shiftDown(7).shiftRight(7))
+    }
+}
+
+namespace conway
+{
+    Counters tick(const BitBoard &previous, BitBoard &current, const kernel::Rule &rule)
+    {
+        WorkerPool pool(1);
+        return tick(previous, current, pool, rule);
+    }
+
+    template <typename ChunkT>
+    Counters tick(const BasicBitBoard<ChunkT> &previous, BasicBitBoard<ChunkT> &current, WorkerPool &pool, const kernel::Rule &rule)
+    {
+        using Board = BasicBitBoard<ChunkT>;
+        using Clock = std::chrono::steady_clock;
+
+        // Lambdas run on pool threads would see their own thread_local, so the
+        // calling thread's one is bound to a reference first.
+        thread_local std::vector<Worker<ChunkT>> scratch;
+        std::vector<Worker<ChunkT>> &workers = scratch;
+
+        current.setGeneration(previous.getGeneration() + 1);
+        current.beginChanges(previous.getGeneration());
+
+        const size_t allocations = current.allocations();
+        const size_t probes = current.probes();
+
+        Counters counters;
+        Clock::time_point lapStart = Clock::now();
+
+        auto lap = [&](uint64_t &phase)
         {
-            Direction direction = Direction::NorthWest;
-            auto [entry, inserted] = potentialChunks->try_emplace(direction.offset(meta.pos), 0, direction.offset(meta.pos));
-            entry->second.neighbors[direction.opposite()] = meta.index; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
-        }
+            Clock::time_point now = Clock::now();
+            phase += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - lapStart).count());
+            lapStart = now;
+        };
+
+        workers.resize(pool.size());
+
+        for (auto &worker : workers)
+            worker.reset(rule);
 
-        if (auto other = board.at(meta.neighbors[Direction::NorthEast]); other != board.end())
+        pool.parallelFor(previous.capacity(), Grain, [&](size_t worker, size_t begin, size_t end)
         {
-            Chunk y = other->node.chunk.shiftRight(7).shiftUp(7);
-            x6 |= y;
-        }
-        else if (potentialChunks && chunk.shiftDown(7).shiftLeft(7))
+            Worker<ChunkT> &self = workers[worker];
+
+            for (auto index = static_cast<typename Board::Index>(begin); index < end; index++)
+            {
+                if (previous.live(index))
+                {
+                    self.counters.live++;
+                    gather(self, previous, current, index);
+                }
+            }
+
+            flush(self, current);
+        });
+
+        lap(counters.nanoseconds.live);
+
+        // Births can only happen on the frontier the previous board kept while it
+        // was written. Slots on it that came alive since are already handled above.
+        const auto &frontier = previous.frontier();
+
+        pool.parallelFor(frontier.size(), Grain, [&](size_t worker, size_t begin, size_t end)
         {
-            Direction direction = Direction::NorthEast;
-            auto [entry, inserted] = potentialChunks->try_emplace(direction.offset(meta.pos), 0, direction.offset(meta.pos));
-            entry->second.neighbors[direction.opposite()] = meta.index; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
-        }
+            Worker<ChunkT> &self = workers[worker];
+
+            for (size_t i = begin; i < end; i++)
+            {
+                if (!previous.live(frontier[i]))
+                {
+                    self.counters.candidates++;
+                    gather(self, previous, current, frontier[i]);
+                }
+            }
+
+            flush(self, current);
+        });
 
-        if (auto other = board.at(meta.neighbors[Direction::SouthWest]); other != board.end())
+        lap(counters.nanoseconds.candidates);
+
+        // Results for positions that already have a slot in the current board are
+        // disjoint and can be written back in parallel. Only new positions have to
+        // go through allocation, which stays serial.
+        pool.run([&](size_t worker)
         {
-            Chunk y = other->node.chunk.shiftLeft(7).shiftDown(7);
-            x5 |= y;
-        }
-        else if (potentialChunks && chunk.shiftUp(7).shiftRight(7))
+            Worker<ChunkT> &self = workers[worker];
+
+            for (const auto &result : self.results)
+            {
+                if (result.slot != Board::Invalid)
+                {
+                    current.revive(result.slot, result.chunk, result.previous, result.activity);
+                    self.revived++;
+                }
+            }
+        });
+
+        lap(counters.nanoseconds.writeBack);
+
+        // Inserting a chunk also extends the frontier with its empty neighbors.
+        for (auto &worker : workers)
         {
-            Direction direction = Direction::SouthWest;
-            auto [entry, inserted] = potentialChunks->try_emplace(direction.offset(meta.pos), 0, direction.offset(meta.pos));
-            entry->second.neighbors[direction.opposite()] = meta.index; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            current.addRevived(worker.revived);
+
+            for (const auto &result : worker.results)
+            {
+                if (result.slot == Board::Invalid)
+                {
+                    current.insert(result.pos, result.chunk, result.previous, result.activity);
+                    counters.lookups++;
+                }
+
+                if (result.activity & Board::ChangedOne)
+                    current.noteChange(result.pos);
+            }
         }
 
-        if (auto other = board.at(meta.neighbors[Direction::SouthEast]); other != board.end())
+        lap(counters.nanoseconds.insert);
+
+        // Revived chunks were written without it, so their frontier is collected
+        // once every chunk of the generation is in place. Walking the slots in order
+        // is much kinder to the cache than following the results.
+        pool.parallelFor(current.capacity(), Grain, [&](size_t worker, size_t begin, size_t end)
         {
-            Chunk y = other->node.chunk.shiftRight(7).shiftDown(7);
-            x7 |= y;
-        }
-        else if (potentialChunks && chunk.shiftUp(7).shiftLeft(7))
+            Worker<ChunkT> &self = workers[worker];
+
+            for (auto index = static_cast<typename Board::Index>(begin); index < end; index++)
+                if (current.live(index))
+                    collectFrontier(self, current, index);
+        });
+
+        for (auto &worker : workers)
         {
-            Direction direction = Direction::SouthEast;
-            auto [entry, inserted] = potentialChunks->try_emplace(direction.offset(meta.pos), 0, direction.offset(meta.pos));
-            entry->second.neighbors[direction.opposite()] = meta.index; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            for (auto index : worker.frontier)
+                current.addFrontier(index);
+
+            for (auto pos : worker.unmapped)
+                current.addFrontier(pos);
+
+            counters.lookups += worker.unmapped.size();
         }
 
-        auto [s01, c01] = halfAdder(x0, x1);
-        auto [s23, c23] = halfAdder(x2, x3);
-        auto [s45, c45] = halfAdder(x4, x5);
-        auto [s67, c67] = halfAdder(x6, x7);
-        auto [q00, q01, c0] = adder2(s01, c01, s23, c23);
-        auto [q10, q11, c1] = adder2(s45, c45, s67, c67);
-        auto [r0, r1, r2, r3] = adder3(q00, q01, c0, q10, q11, c1);
+        lap(counters.nanoseconds.frontier);
 
-        return r1 & ~r2 & (r0 | chunk);
-    }
-}
+        // The next tick walks this board in slot order and loads the neighbors of
+        // every chunk, which only stays cache friendly while slot order follows
+        // position. Allocation scatters it over time, so the slots get sorted again
+        // once half as many have been handed out as the board holds.
+        if (current.scattered())
+            current.relayout();
 
-namespace conway
-{
-    void tick(const BitBoard &previous, BitBoard &current)
-    {
-        current.setGeneration(previous.getGeneration() + 1);
+        current.setHistory(std::min(previous.history() + 1, 2U));
+        lap(counters.nanoseconds.relayout);
 
-        boost::unordered::unordered_flat_map<sf::Vector2i, BitBoard::Meta> potentialChunks;
+        for (const auto &worker : workers)
+            counters += worker.counters;
 
-        for (const auto &[node, meta] : previous)
-            if (auto chunk = process(previous, node.chunk, meta, &potentialChunks))
-                current.store(meta.pos, chunk);
+        counters.allocated = current.allocations() - allocations;
+        counters.probes = current.probes() - probes;
 
-        for (const auto &[pos, meta] : potentialChunks)
-            if (auto chunk = process(previous, Chunk(), meta))
-                current.store(pos, chunk);
+        return counters;
     }
+
+    template Counters tick(const BasicBitBoard<BasicChunk<8>> &, BasicBitBoard<BasicChunk<8>> &, WorkerPool &, const kernel::Rule &);
+    template Counters tick(const BasicBitBoard<BasicChunk<16>> &, BasicBitBoard<BasicChunk<16>> &, WorkerPool &, const kernel::Rule &);
+    template Counters tick(const BasicBitBoard<BasicChunk<32>> &, BasicBitBoard<BasicChunk<32>> &, WorkerPool &, const kernel::Rule &);
+    template Counters tick(const BasicBitBoard<BasicChunk<64>> &, BasicBitBoard<BasicChunk<64>> &, WorkerPool &, const kernel::Rule &);
 }
@@ -0,0 +1,181 @@
+#include "kernel.hpp"
+
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace
+{
+    using EvolveFunction = void (*)(const kernel::Batch &, kernel::Results &, const kernel::Rule &);
+
+    [[nodiscard]] EvolveFunction function(kernel::Variant variant)
+    {
+        switch (variant)
+        {
+        case kernel::Variant::Avx2:
+            return kernel::detail::evolveAvx2;
+
+        case kernel::Variant::Avx512:
+            return kernel::detail::evolveAvx512;
+
+        default:
+            return kernel::detail::evolveScalar;
+        }
+    }
+
+    // Picked once at startup; select() may override it before ticking begins.
+    std::atomic<kernel::Variant> selectedVariant = kernel::detect(); // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+    std::atomic<EvolveFunction> selectedFunction = function(selectedVariant); // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+}
+
+namespace kernel
+{
+    void evolve(const Batch &batch, Results &results, const Rule &rule)
+    {
+        selectedFunction.load(std::memory_order_relaxed)(batch, results, rule);
+    }
+
+    std::optional<Rule> parseRule(std::string_view notation)
+    {
+        // Digits up to the next '/' or the end, as a set of neighbour counts.
+        auto counts = [&](std::string_view::size_type &at) -> std::optional<uint16_t>
+        {
+            uint16_t set = 0;
+
+            for (; at < notation.size() && notation[at] != '/'; at++)
+            {
+                if (notation[at] < '0' || notation[at] > '8')
+                    return std::nullopt;
+
+                set |= static_cast<uint16_t>(1U << (notation[at] - '0'));
+            }
+
+            return set;
+        };
+
+        auto letter = [&](std::string_view::size_type at) -> char
+        {
+            return at < notation.size() ? static_cast<char>(std::toupper(static_cast<unsigned char>(notation[at]))) : '\0';
+        };
+
+        std::string_view::size_type slash = notation.find('/');
+
+        if (slash == std::string_view::npos || notation.find('/', slash + 1) != std::string_view::npos)
+            return std::nullopt;
+
+        char first = letter(0);
+        char second = letter(slash + 1);
+        bool lettered = first == 'B' || first == 'S';
+
+        if (lettered && !((first == 'B' && second == 'S') || (first == 'S' && second == 'B')))
+            return std::nullopt;
+
+        std::string_view::size_type at = lettered ? 1 : 0;
+        std::optional<uint16_t> left = counts(at);
+        at = slash + (lettered ? 2 : 1);
+        std::optional<uint16_t> right = counts(at);
+
+        if (!left || !right)
+            return std::nullopt;
+
+        // Without letters the survival counts come first.
+        if (first == 'B')
+            return Rule{*left, *right};
+
+        return Rule{*right, *left};
+    }
+
+    std::string notation(const Rule &rule)
+    {
+        std::string result = "B";
+
+        for (unsigned int n = 0; n <= 8; n++)
+            if ((rule.birth >> n) & 1U)
+                result += static_cast<char>('0' + n);
+
+        result += "/S";
+
+        for (unsigned int n = 0; n <= 8; n++)
+            if ((rule.survival >> n) & 1U)
+                result += static_cast<char>('0' + n);
+
+        return result;
+    }
+
+    std::string_view name(Variant variant)
+    {
+        switch (variant)
+        {
+        case Variant::Scalar:
+            return "scalar";
+
+        case Variant::Avx2:
+            return "avx2";
+
+        case Variant::Avx512:
+            return "avx512";
+
+        default:
+            throw std::invalid_argument("unknown kernel variant");
+        }
+    }
+
+    std::optional<Variant> parse(std::string_view name)
+    {
+        for (auto variant : {Variant::Scalar, Variant::Avx2, Variant::Avx512})
+            if (name == kernel::name(variant))
+                return variant;
+
+        return std::nullopt;
+    }
+
+    bool supported(Variant variant)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+
+        switch (variant)
+        {
+        case Variant::Avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+
+        case Variant::Avx512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("bmi2");
+
+        default:
+            return true;
+        }
+#else
+        return variant == Variant::Scalar;
+#endif
+    }
+
+    Variant detect()
+    {
+        if (supported(Variant::Avx512))
+            return Variant::Avx512;
+
+        if (supported(Variant::Avx2))
+            return Variant::Avx2;
+
+        return Variant::Scalar;
+    }
+
+    Variant selected()
+    {
+        return selectedVariant;
+    }
+
+    void select(Variant variant)
+    {
+        if (!supported(variant))
+            throw std::runtime_error("The " + std::string(name(variant)) + " kernel is not supported by this CPU.");
+
+        selectedVariant = variant;
+        selectedFunction = function(variant);
+    }
+}
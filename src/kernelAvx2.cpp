@@ -0,0 +1,13 @@
+#include "kernel.hpp"
+
+namespace kernel::detail
+{
+    void evolveAvx2(const Batch &batch, Results &results, const Rule &rule)
+    {
+#if defined(__AVX2__)
+        evolveBatch<4>(batch, results, rule);
+#else
+        evolveBatch<1>(batch, results, rule);
+#endif
+    }
+}
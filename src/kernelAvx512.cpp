@@ -0,0 +1,13 @@
+#include "kernel.hpp"
+
+namespace kernel::detail
+{
+    void evolveAvx512(const Batch &batch, Results &results, const Rule &rule)
+    {
+#if defined(__AVX512F__)
+        evolveBatch<8>(batch, results, rule);
+#else
+        evolveBatch<1>(batch, results, rule);
+#endif
+    }
+}
@@ -0,0 +1,9 @@
+#include "kernel.hpp"
+
+namespace kernel::detail
+{
+    void evolveScalar(const Batch &batch, Results &results, const Rule &rule)
+    {
+        evolveBatch<1>(batch, results, rule);
+    }
+}
@@ -0,0 +1,525 @@
+#include "pattern.hpp"
+#include "BitBoard.hpp"
+#include "Chunk.hpp"
+#include "utility.hpp"
+
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    // Cheaper than the <cctype> functions, which go through the locale.
+    [[nodiscard]] constexpr bool isDigit(int c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    [[nodiscard]] constexpr bool isBlank(int c)
+    {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    // Buffered character source that keeps track of the line for error messages.
+    class Reader
+    {
+    public:
+        static constexpr int End = -1;
+
+    private:
+        std::istream &m_input;
+        std::vector<char> m_buffer = std::vector<char>(size_t{1} << 16);
+        size_t m_position = 0;
+        size_t m_size = 0;
+        size_t m_line = 1;
+
+        bool refill()
+        {
+            m_input.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+            m_size = static_cast<size_t>(m_input.gcount());
+            m_position = 0;
+            return m_size > 0;
+        }
+
+    public:
+        explicit Reader(std::istream &input) : m_input(input) {}
+
+        [[nodiscard]] int peek()
+        {
+            if (m_position == m_size && !refill())
+                return End;
+
+            return static_cast<unsigned char>(m_buffer[m_position]);
+        }
+
+        int get()
+        {
+            int c = peek();
+
+            if (c != End)
+            {
+                m_position++;
+
+                if (c == '\n')
+                    m_line++;
+            }
+
+            return c;
+        }
+
+        void skipLine()
+        {
+            for (int c = get(); c != End && c != '\n'; c = get())
+            {
+            }
+        }
+
+        void skipBlanks()
+        {
+            while (isBlank(peek()))
+                get();
+        }
+
+        // Reads a decimal number, the first digit of which has already been peeked.
+        // With acrossLines, digits carry on after line breaks, as in RLE files
+        // wrapped at a fixed width.
+        [[nodiscard]] int64_t number(bool acrossLines = false)
+        {
+            int64_t value = 0;
+
+            for (;;)
+            {
+                if (acrossLines && (peek() == '\n' || peek() == '\r'))
+                {
+                    get();
+                    continue;
+                }
+
+                if (!isDigit(peek()))
+                    break;
+
+                value = (value * 10) + (get() - '0');
+
+                if (value > std::numeric_limits<int>::max())
+                    fail("Number is too large.");
+            }
+
+            return value;
+        }
+
+        [[noreturn]] void fail(const std::string &message) const
+        {
+            throw std::runtime_error("line " + std::to_string(m_line) + ": " + message);
+        }
+    };
+
+    // ORs a chunk into the board, keeping whatever was there already.
+    void merge(BitBoard &board, BitBoard::ChunkPos pos, Chunk chunk)
+    {
+        if (auto existing = board.find(pos); existing != board.end())
+            chunk |= existing->chunk;
+
+        board.store(pos, chunk);
+    }
+
+    // Collects runs of live cells into chunk words for one band of Chunk::Size rows
+    // at a time, so the board is touched once per chunk instead of once per cell.
+    // Rows have to arrive from top to bottom.
+    class BandWriter
+    {
+    private:
+        BitBoard &m_board;
+        sf::Vector2i m_origin;
+        int m_firstColumn; // chunk column of m_words[0]
+        int m_band = std::numeric_limits<int>::min();
+        std::vector<uint64_t> m_words;
+        std::vector<size_t> m_touched;
+
+    public:
+        BandWriter(BitBoard &board, sf::Vector2i origin) : m_board(board), m_origin(origin), m_firstColumn(utility::floorDiv(origin.x, static_cast<int>(Chunk::Size))) {}
+
+        BandWriter(const BandWriter &) = delete;
+        BandWriter &operator=(const BandWriter &) = delete;
+        BandWriter(BandWriter &&) = delete;
+        BandWriter &operator=(BandWriter &&) = delete;
+
+        ~BandWriter() = default;
+
+        // Sets length cells starting at (x, y) relative to the origin.
+        void run(const Reader &reader, int64_t x, int64_t y, int64_t length)
+        {
+            constexpr auto Size = static_cast<int64_t>(Chunk::Size);
+
+            if (x + length + m_origin.x > std::numeric_limits<int>::max() || y + m_origin.y > std::numeric_limits<int>::max())
+                reader.fail("Pattern does not fit on the board.");
+
+            int64_t cellX = x + m_origin.x;
+            auto cellY = static_cast<int>(y + m_origin.y);
+            int band = utility::floorDiv(cellY, static_cast<int>(Size));
+
+            if (band != m_band)
+            {
+                flush();
+                m_band = band;
+            }
+
+            auto row = static_cast<unsigned int>(cellY - (band * static_cast<int>(Size)));
+
+            while (length > 0)
+            {
+                int64_t column = (cellX >= 0 ? cellX : cellX - (Size - 1)) / Size;
+                auto bit = static_cast<unsigned int>(cellX - (column * Size));
+                auto count = static_cast<unsigned int>(std::min<int64_t>(length, Size - bit));
+                auto word = static_cast<size_t>(column - m_firstColumn);
+
+                if (word >= m_words.size())
+                    m_words.resize(word + 1);
+
+                if (!m_words[word])
+                    m_touched.push_back(word);
+
+                uint64_t cells = count == Size ? 0xFF : (uint64_t{1} << count) - 1;
+                m_words[word] |= cells << (bit + (row * Size));
+
+                cellX += count;
+                length -= count;
+            }
+        }
+
+        void flush()
+        {
+            for (auto word : m_touched)
+            {
+                merge(m_board, {m_firstColumn + static_cast<int>(word), m_band}, Chunk(m_words[word]));
+                m_words[word] = 0;
+            }
+
+            m_touched.clear();
+        }
+    };
+
+    // Run length encoded cells after optional '#' comment lines and an "x = ..." header.
+    void readRle(Reader &reader, BandWriter &writer)
+    {
+        for (reader.skipBlanks(); reader.peek() == '#' || reader.peek() == 'x'; reader.skipBlanks())
+            reader.skipLine();
+
+        int64_t x = 0;
+        int64_t y = 0;
+
+        for (;;)
+        {
+            reader.skipBlanks();
+            int c = reader.peek();
+
+            if (c == Reader::End || c == '!')
+                break;
+
+            int64_t count = isDigit(c) ? reader.number(true) : 1;
+            reader.skipBlanks();
+
+            switch (reader.get())
+            {
+            case 'b':
+            case '.':
+                x += count;
+                break;
+
+            case 'o':
+            case 'A':
+                writer.run(reader, x, y, count);
+                x += count;
+                break;
+
+            case '$':
+                y += count;
+                x = 0;
+                break;
+
+            case Reader::End:
+                reader.fail("Run count without a cell state.");
+
+            default:
+                reader.fail("Unsupported cell state in RLE pattern.");
+            }
+        }
+
+        writer.flush();
+    }
+
+    // One row per line, '.' for dead and 'O' or '*' for live cells; lines starting
+    // with '!' are comments.
+    void readPlaintext(Reader &reader, BandWriter &writer)
+    {
+        int64_t y = 0;
+
+        while (reader.peek() != Reader::End)
+        {
+            if (reader.peek() == '!')
+            {
+                reader.skipLine();
+                continue;
+            }
+
+            int64_t x = 0;
+            int64_t start = 0;
+            bool alive = false;
+
+            for (int c = reader.get(); c != Reader::End && c != '\n'; c = reader.get())
+            {
+                if (c == '\r')
+                    continue;
+
+                bool cell = c == 'O' || c == '*';
+
+                if (!cell && c != '.')
+                    reader.fail("Unexpected character in plaintext pattern.");
+
+                if (cell && !alive)
+                    start = x;
+                else if (!cell && alive)
+                    writer.run(reader, start, y, x - start);
+
+                alive = cell;
+                x++;
+            }
+
+            if (alive)
+                writer.run(reader, start, y, x - start);
+
+            y++;
+        }
+
+        writer.flush();
+    }
+
+    // Golly's macrocell format: a "[M2]" line, then one quadtree node per line.
+    // Leaves are 8x8 squares written as '.', '*' and '$' rows, which map straight
+    // onto chunk words; other lines give the level and the 1-based indices of the
+    // north west, north east, south west and south east children, 0 for empty.
+    // Each node may only refer to earlier ones, and the last one is the root.
+    void readMacrocell(Reader &reader, BitBoard &board, sf::Vector2i origin)
+    {
+        static_assert(Chunk::Size == 8, "macrocell leaves are 8x8");
+
+        struct Node
+        {
+            uint64_t leaf = 0;
+            std::array<uint32_t, 4> children = {0, 0, 0, 0};
+            unsigned int level = 3;
+        };
+
+        std::vector<Node> nodes(1); // node 0 is the empty one
+
+        if (reader.get() != '[' || reader.get() != 'M' || reader.get() != '2' || reader.get() != ']')
+            reader.fail("Macrocell pattern does not start with [M2].");
+
+        reader.skipLine();
+
+        for (reader.skipBlanks(); reader.peek() != Reader::End; reader.skipBlanks())
+        {
+            int c = reader.peek();
+
+            if (c == '#')
+            {
+                reader.skipLine();
+            }
+            else if (c == '.' || c == '*' || c == '$')
+            {
+                Node &node = nodes.emplace_back();
+                unsigned int x = 0;
+                unsigned int y = 0;
+
+                for (c = reader.get(); c != Reader::End && c != '\n'; c = reader.get())
+                {
+                    if (c == '$')
+                    {
+                        x = 0;
+                        y++;
+                        continue;
+                    }
+
+                    if (c == '\r')
+                        continue;
+
+                    if ((c != '.' && c != '*') || x >= 8 || y >= 8)
+                        reader.fail("Malformed macrocell leaf.");
+
+                    if (c == '*')
+                        node.leaf |= uint64_t{1} << ((y * 8) + x);
+
+                    x++;
+                }
+            }
+            else if (isDigit(c))
+            {
+                Node &node = nodes.emplace_back();
+                node.level = static_cast<unsigned int>(reader.number());
+
+                if (node.level <= 3)
+                    reader.fail("Only two-state macrocell patterns are supported.");
+
+                if (node.level > 32)
+                    reader.fail("Pattern does not fit on the board.");
+
+                for (auto &child : node.children)
+                {
+                    reader.skipBlanks();
+
+                    if (!isDigit(reader.peek()))
+                        reader.fail("Macrocell node needs four children.");
+
+                    int64_t index = reader.number();
+
+                    if (index >= static_cast<int64_t>(nodes.size()) - 1 || (index != 0 && nodes[static_cast<size_t>(index)].level != node.level - 1))
+                        reader.fail("Macrocell node refers to an invalid child.");
+
+                    child = static_cast<uint32_t>(index);
+                }
+            }
+            else
+            {
+                reader.fail("Unexpected character in macrocell pattern.");
+            }
+        }
+
+        if (nodes.size() == 1)
+            return;
+
+        // NOLINTNEXTLINE(misc-no-recursion)
+        auto emit = [&](auto &self, uint32_t index, int64_t x, int64_t y) -> void
+        {
+            const Node &node = nodes[index];
+
+            if (index == 0)
+                return;
+
+            if (node.level == 3)
+            {
+                if (x < std::numeric_limits<int>::min() || x > std::numeric_limits<int>::max() || y < std::numeric_limits<int>::min() || y > std::numeric_limits<int>::max())
+                    throw std::runtime_error("Pattern does not fit on the board.");
+
+                if (node.leaf)
+                    merge(board, {static_cast<int>(x), static_cast<int>(y)}, Chunk(node.leaf));
+
+                return;
+            }
+
+            const int64_t half = int64_t{1} << (node.level - 4);
+            self(self, node.children[0], x, y);
+            self(self, node.children[1], x + half, y);
+            self(self, node.children[2], x, y + half);
+            self(self, node.children[3], x + half, y + half);
+        };
+
+        const auto root = static_cast<uint32_t>(nodes.size() - 1);
+        const int64_t half = nodes[root].level > 3 ? int64_t{1} << (nodes[root].level - 4) : 0;
+        BitBoard::ChunkPos centre = utility::floorDiv(origin, {static_cast<int>(Chunk::Size), static_cast<int>(Chunk::Size)});
+        emit(emit, root, centre.x - half, centre.y - half);
+    }
+}
+
+namespace pattern
+{
+    std::string_view name(Format format)
+    {
+        switch (format)
+        {
+        case Format::Rle:
+            return "rle";
+
+        case Format::Plaintext:
+            return "plaintext";
+
+        case Format::Macrocell:
+            return "macrocell";
+
+        default:
+            throw std::invalid_argument("unknown pattern format");
+        }
+    }
+
+    std::optional<Format> fromExtension(std::string_view path)
+    {
+        auto extension = path.substr(std::min(path.size(), path.rfind('.')));
+        std::string lower(extension);
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c)
+        {
+            return static_cast<char>(std::tolower(c));
+        });
+
+        if (lower == ".rle")
+            return Format::Rle;
+
+        if (lower == ".cells")
+            return Format::Plaintext;
+
+        if (lower == ".mc")
+            return Format::Macrocell;
+
+        return std::nullopt;
+    }
+
+    void read(std::istream &input, Format format, BitBoard &board, sf::Vector2i origin)
+    {
+        Reader reader(input);
+
+        if (format == Format::Macrocell)
+        {
+            readMacrocell(reader, board, origin);
+            return;
+        }
+
+        BandWriter writer(board, origin);
+
+        if (format == Format::Rle)
+            readRle(reader, writer);
+        else
+            readPlaintext(reader, writer);
+    }
+
+    void load(const std::string &path, BitBoard &board, sf::Vector2i origin)
+    {
+        std::ifstream input(path, std::ios::binary);
+
+        if (!input)
+            throw std::runtime_error("Cannot open pattern file '" + path + "'.");
+
+        std::optional<Format> format = fromExtension(path);
+
+        if (!format)
+        {
+            int c = input.peek();
+
+            if (c == '[')
+                format = Format::Macrocell;
+            else if (c == '!' || c == '.' || c == 'O' || c == '*')
+                format = Format::Plaintext;
+            else
+                format = Format::Rle;
+        }
+
+        try
+        {
+            read(input, *format, board, origin);
+        }
+        catch (const std::runtime_error &error)
+        {
+            throw std::runtime_error("Cannot load pattern file '" + path + "', " + error.what());
+        }
+
+        if (input.bad())
+            throw std::runtime_error("Cannot read pattern file '" + path + "'.");
+    }
+}
@@ -0,0 +1,301 @@
+#include "snapshot.hpp"
+#include "BitBoard.hpp"
+#include "Chunk.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    static_assert(std::endian::native == std::endian::little, "snapshots are stored little endian");
+    static_assert(Chunk::Size == 8, "snapshot records hold 8x8 chunks");
+
+    [[noreturn]] void fail(const std::string &message, const std::string &path)
+    {
+        throw std::runtime_error(message + " '" + path + "': " + std::strerror(errno));
+    }
+
+    // Closes a file descriptor when it goes out of scope.
+    class File
+    {
+    private:
+        int m_descriptor;
+
+    public:
+        explicit File(int descriptor) : m_descriptor(descriptor) {}
+
+        File(const File &) = delete;
+        File &operator=(const File &) = delete;
+        File(File &&) = delete;
+        File &operator=(File &&) = delete;
+
+        ~File()
+        {
+            if (m_descriptor >= 0)
+                ::close(m_descriptor);
+        }
+
+        [[nodiscard]] int get() const
+        {
+            return m_descriptor;
+        }
+
+        // Closes the file now, so that errors can be reported.
+        bool close()
+        {
+            int descriptor = std::exchange(m_descriptor, -1);
+            return ::close(descriptor) == 0;
+        }
+    };
+
+    // Removes a file when it goes out of scope, unless it was kept.
+    class Temporary
+    {
+    private:
+        std::string m_path;
+
+    public:
+        explicit Temporary(std::string path) : m_path(std::move(path)) {}
+
+        Temporary(const Temporary &) = delete;
+        Temporary &operator=(const Temporary &) = delete;
+        Temporary(Temporary &&) = delete;
+        Temporary &operator=(Temporary &&) = delete;
+
+        ~Temporary()
+        {
+            if (!m_path.empty())
+                ::unlink(m_path.c_str());
+        }
+
+        void keep()
+        {
+            m_path.clear();
+        }
+    };
+
+    // Read-only view of a whole file, unmapped when it goes out of scope.
+    class Mapping
+    {
+    private:
+        void *m_data = nullptr;
+        size_t m_size = 0;
+
+    public:
+        Mapping(int descriptor, size_t size) : m_size(size)
+        {
+            if (size == 0)
+                return;
+
+            m_data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+            if (m_data == MAP_FAILED) // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+            {
+                m_data = nullptr;
+                return;
+            }
+
+            // Both are hints: read ahead from the start and drop pages behind us.
+            ::madvise(m_data, size, MADV_WILLNEED);
+            ::madvise(m_data, size, MADV_SEQUENTIAL);
+        }
+
+        Mapping(const Mapping &) = delete;
+        Mapping &operator=(const Mapping &) = delete;
+        Mapping(Mapping &&) = delete;
+        Mapping &operator=(Mapping &&) = delete;
+
+        ~Mapping()
+        {
+            if (m_data)
+                ::munmap(m_data, m_size);
+        }
+
+        [[nodiscard]] bool valid() const
+        {
+            return m_data || m_size == 0;
+        }
+
+        // The object of type T at offset bytes into the file. Copied out, as the
+        // mapping makes no promise about alignment beyond the page.
+        template <typename T>
+        [[nodiscard]] T read(size_t offset) const
+        {
+            T value;
+            std::memcpy(&value, static_cast<const std::byte *>(m_data) + offset, sizeof(T)); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            return value;
+        }
+    };
+
+    [[nodiscard]] constexpr bool before(const snapshot::Record &a, const snapshot::Record &b)
+    {
+        return std::pair(a.y, a.x) < std::pair(b.y, b.x);
+    }
+}
+
+namespace snapshot
+{
+    size_t save(const BitBoard &board, const std::string &path)
+    {
+        std::vector<Record> records;
+        records.reserve(board.size());
+
+        // Boards keep empty chunks around while they are still active; those carry
+        // nothing a restarted run needs.
+        for (const auto &[chunk, pos] : board)
+            if (chunk)
+                records.push_back({pos.x, pos.y, chunk.data()});
+
+        std::sort(records.begin(), records.end(), before);
+
+        Header header = {Magic, Version, Chunk::Size, board.getGeneration(), records.size()};
+
+        // Every save writes a file of its own, so that a checkpoint and a save to the
+        // same path cannot write into each other's. It is removed again unless it
+        // replaces the snapshot.
+        std::string temporary = path + ".XXXXXX";
+        File file(::mkostemp(temporary.data(), O_CLOEXEC));
+
+        if (file.get() < 0)
+            fail("Cannot create snapshot file", temporary);
+
+        Temporary guard(temporary);
+
+        // mkostemp() makes the file readable by its owner only.
+        if (::fchmod(file.get(), 0644) != 0)
+            fail("Cannot create snapshot file", temporary);
+
+        std::array<iovec, 2> parts = {{{&header, sizeof(header)}, {records.data(), records.size() * sizeof(Record)}}};
+        size_t bytes = parts[0].iov_len + parts[1].iov_len;
+        size_t part = 0;
+
+        // One writev() normally takes everything; it only has to be repeated when the
+        // kernel stops short.
+        while (part < parts.size())
+        {
+            if (parts[part].iov_len == 0) // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            {
+                part++;
+                continue;
+            }
+
+            ssize_t written = ::writev(file.get(), &parts[part], static_cast<int>(parts.size() - part)); // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                fail("Cannot write snapshot file", temporary);
+            }
+
+            // A part written only in part stays current, as writes of more than
+            // about 2 GiB always stop short.
+            for (auto remaining = static_cast<size_t>(written); remaining > 0;)
+            {
+                iovec &current = parts[part]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+                size_t taken = std::min(remaining, current.iov_len);
+                current.iov_base = static_cast<std::byte *>(current.iov_base) + taken; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                current.iov_len -= taken;
+                remaining -= taken;
+
+                if (current.iov_len == 0)
+                    part++;
+            }
+        }
+
+        if (::fsync(file.get()) != 0 || !file.close())
+            fail("Cannot write snapshot file", temporary);
+
+        if (std::rename(temporary.c_str(), path.c_str()) != 0)
+            fail("Cannot replace snapshot file", path);
+
+        guard.keep();
+        return bytes;
+    }
+
+    void load(const std::string &path, BitBoard &board)
+    {
+        File file(::open(path.c_str(), O_RDONLY | O_CLOEXEC)); // NOLINT(cppcoreguidelines-pro-type-vararg)
+
+        if (file.get() < 0)
+            fail("Cannot open snapshot file", path);
+
+        struct stat status = {};
+
+        if (::fstat(file.get(), &status) != 0)
+            fail("Cannot read snapshot file", path);
+
+        auto size = static_cast<size_t>(status.st_size);
+
+        auto invalid = [&](const std::string &reason)
+        {
+            return std::runtime_error("Invalid snapshot file '" + path + "': " + reason);
+        };
+
+        if (size < sizeof(Header))
+            throw invalid("it is too short.");
+
+        Mapping mapping(file.get(), size);
+
+        if (!mapping.valid())
+            fail("Cannot map snapshot file", path);
+
+        auto header = mapping.read<Header>(0);
+
+        if (header.magic != Magic)
+            throw invalid("it is not a snapshot.");
+
+        if (header.version != Version)
+            throw invalid("version " + std::to_string(header.version) + " is not supported.");
+
+        if (header.chunkSize != Chunk::Size)
+            throw invalid("it holds " + std::to_string(header.chunkSize) + "x" + std::to_string(header.chunkSize) + " chunks.");
+
+        if (header.generation == 0)
+            throw invalid("its generation is out of range.");
+
+        if (header.count >= BitBoard::Invalid || header.count != (size - sizeof(Header)) / sizeof(Record) || (size - sizeof(Header)) % sizeof(Record))
+            throw invalid("its size does not match its chunk count.");
+
+        auto count = static_cast<BitBoard::Index>(header.count);
+
+        auto record = [&](BitBoard::Index index)
+        {
+            return mapping.read<Record>(sizeof(Header) + (size_t{index} * sizeof(Record)));
+        };
+
+        // Checked up front, so that a bad file leaves the board as it was. This pass
+        // also brings the file into the page cache for the one that builds the board.
+        for (BitBoard::Index index = 0; index < count; index++)
+        {
+            Record current = record(index);
+
+            if (current.cells == 0)
+                throw invalid("it contains an empty chunk.");
+
+            if (index > 0 && !before(record(index - 1), current))
+                throw invalid("its chunks are not sorted.");
+        }
+
+        board.assign(static_cast<BitBoard::Generation>(header.generation), count, [&](BitBoard::Index index)
+        {
+            Record current = record(index);
+            return std::pair(BitBoard::ChunkPos(current.x, current.y), Chunk(current.cells));
+        });
+    }
+}